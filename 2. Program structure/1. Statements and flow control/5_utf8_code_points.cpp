@@ -0,0 +1,289 @@
+/*Iterating over the characters of UTF-8 text
+The range-based for loop over a string, for (char c : str), visits each char of the string. For English text,
+each char is a character, but most text today is encoded in UTF-8, where a character (a code point of Unicode)
+takes from one to four chars:
+
+- 1 byte,  0xxxxxxx:                             the 128 ASCII characters (U+0000 to U+007F)
+- 2 bytes, 110xxxxx 10xxxxxx:                    most other European alphabets, like the á or ñ of Spanish
+- 3 bytes, 1110xxxx 10xxxxxx 10xxxxxx:           the rest of the basic plane, like Chinese or Japanese
+- 4 bytes, 11110xxx 10xxxxxx 10xxxxxx 10xxxxxx:  emoji and rarer scripts (up to U+10FFFF)
+
+The x are the bits of the code point. So for (char c : str) visits the pieces of the characters separately,
+and printing them one by one between brackets breaks them.
+
+Not every sequence of bytes is valid UTF-8: a continuation byte (10xxxxxx) without a first byte, a sequence cut
+before its end, a code point written with more bytes than needed (called overlong), or the values U+D800 to
+U+DFFF (surrogates) are errors. Text read from outside the program should be validated before it is decoded.
+
+The function valid_utf8 below does not follow the text one sequence at a time, since the length of each one
+would decide where the next one starts, and the loop could only go one sequence per step. Instead, it checks
+blocks of 32 bytes, looking at every byte in the same way, together with the 3 bytes before it: a byte must be
+a continuation byte exactly when one of those 3 starts a sequence long enough to reach it (a byte from 0xC0 just
+before it, from 0xE0 two bytes before, from 0xF0 three bytes before), and a few values of the byte after a first
+byte are not allowed, to reject overlong sequences, surrogates and values above U+10FFFF. The loop over a block
+has no branches, only comparisons combined with | and &, so the compiler can check 16 bytes at a time with the
+vector instructions of the processor. Since most text is mostly ASCII, blocks whose bytes are all ASCII, tested
+8 bytes at a time with a single 64-bit integer, are skipped without even this.
+
+Decoding needs the length of each sequence, and decode_block finds it in a table indexed by the first byte of
+the sequence, which also tells the range of values allowed for its second byte.
+
+The class code_points can be used in a range-based for loop to visit the code points of a string. Instead of
+decoding one code point each time the loop asks for the next one, it decodes them in blocks of 64 into an array,
+with the same 8-byte test for ASCII, and the loop then reads them from the array.*/
+
+// code points of UTF-8 text
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <chrono>
+#include <algorithm>
+#include <stdint.h>
+using namespace std;
+
+struct utf8_lead {
+  unsigned char length;          // 0 if the byte cannot start a sequence
+  unsigned char low, high;       // allowed range of the second byte
+};
+
+struct utf8_table {
+  utf8_lead lead[256];
+  utf8_table ()
+  {
+    for (int b=0; b<256; b++) {
+      utf8_lead l = {0, 0x80, 0xBF};
+      if (b < 0x80) l.length = 1;
+      else if (b >= 0xC2 && b <= 0xDF) l.length = 2;
+      else if (b >= 0xE0 && b <= 0xEF) l.length = 3;
+      else if (b >= 0xF0 && b <= 0xF4) l.length = 4;
+      if (b == 0xE0) l.low = 0xA0;         // overlong
+      if (b == 0xED) l.high = 0x9F;        // surrogates
+      if (b == 0xF0) l.low = 0x90;         // overlong
+      if (b == 0xF4) l.high = 0x8F;        // above U+10FFFF
+      lead[b] = l;
+    }
+  }
+};
+
+const utf8_table utf8;
+
+// true if none of the 8 bytes at p has its highest bit set
+inline bool ascii8 (const unsigned char* p)
+{
+  uint64_t word;
+  memcpy (&word, p, 8);
+  return (word & 0x8080808080808080u) == 0;
+}
+
+// true if the 32 bytes at p are all ASCII
+inline bool ascii32 (const unsigned char* p)
+{
+  return ascii8 (p) && ascii8 (p+8) && ascii8 (p+16) && ascii8 (p+24);
+}
+
+// true if one of the 32 bytes at p is not where it can be, looking also at the 3 bytes before p
+inline bool invalid_block (const unsigned char* p)
+{
+  unsigned char bad = 0;
+  for (int j=0; j<32; j++) {
+    unsigned char c = p[j], p1 = p[j-1], p2 = p[j-2], p3 = p[j-3];
+    // c must be a continuation byte exactly when one of the 3 bytes before it starts a sequence that reaches it
+    unsigned char continuation = (c & 0xC0) == 0x80;
+    unsigned char expected = (p1 >= 0xC0) | (p2 >= 0xE0) | (p3 >= 0xF0);
+    bad |= continuation ^ expected;
+    bad |= (c == 0xC0) | (c == 0xC1) | (c >= 0xF5);            // can never appear
+    bad |= (p1 == 0xE0) & (c < 0xA0);                          // overlong
+    bad |= (p1 == 0xED) & (c > 0x9F);                          // surrogates
+    bad |= (p1 == 0xF0) & (c < 0x90);                          // overlong
+    bad |= (p1 == 0xF4) & (c > 0x8F);                          // above U+10FFFF
+  }
+  return bad != 0;
+}
+
+bool valid_utf8 (const char* text, size_t n)
+{
+  const unsigned char* s = (const unsigned char*) text;
+  // the first and the last block are copied after 3 bytes of context, and padded with zeros (ASCII)
+  unsigned char window[3+32] = {0};
+  size_t count = n < 32 ? n : 32;
+  memcpy (window+3, s, count);
+  if (invalid_block (window+3)) return false;
+  size_t i = count;
+  for (; i+32 <= n; i+=32) {
+    if ((s[i-3] | s[i-2] | s[i-1]) < 0x80 && ascii32 (s+i)) continue;
+    if (invalid_block (s+i)) return false;
+  }
+  if (i < n) {
+    memcpy (window, s+i-3, 3+n-i);
+    memset (window+3+n-i, 0, 32-(n-i));
+    if (invalid_block (window+3)) return false;
+  }
+  // the last sequence must not go past the end
+  unsigned char last[3] = {0, 0, 0};
+  memcpy (last + 3-min (n, size_t (3)), s+n-min (n, size_t (3)), min (n, size_t (3)));
+  return last[2] < 0xC0 && last[1] < 0xE0 && last[0] < 0xF0;
+}
+
+// decodes at most max code points from [p,end), advances p, and returns how many were decoded;
+// bytes that are not valid UTF-8 are decoded as U+FFFD, the replacement character
+int decode_block (const char*& p, const char* end, char32_t* out, int max)
+{
+  const unsigned char* s = (const unsigned char*) p;
+  const unsigned char* e = (const unsigned char*) end;
+  int count = 0;
+  while (count < max && s < e) {
+    if (count + 8 <= max && e - s >= 8 && ascii8 (s)) {
+      for (int k=0; k<8; k++) out[count+k] = s[k];
+      count += 8;
+      s += 8;
+      continue;
+    }
+    utf8_lead l = utf8.lead[*s];
+    if (l.length == 1) {
+      out[count++] = *s++;
+      continue;
+    }
+    bool valid = l.length != 0 && e - s >= l.length && s[1] >= l.low && s[1] <= l.high;
+    for (int k=2; valid && k<l.length; k++)
+      valid = (s[k] & 0xC0) == 0x80;
+    if (!valid) {
+      out[count++] = 0xFFFD;
+      s++;
+      continue;
+    }
+    char32_t c = *s & (0x7F >> l.length);
+    for (int k=1; k<l.length; k++)
+      c = (c << 6) | (s[k] & 0x3F);
+    out[count++] = c;
+    s += l.length;
+  }
+  p = (const char*) s;
+  return count;
+}
+
+// writes the UTF-8 encoding of c into out, and returns its length
+int encode (char32_t c, char* out)
+{
+  if (c < 0x80) {out[0] = char (c); return 1;}
+  if (c < 0x800) {out[0] = char (0xC0 | c>>6); out[1] = char (0x80 | (c & 0x3F)); return 2;}
+  if (c < 0x10000) {
+    out[0] = char (0xE0 | c>>12); out[1] = char (0x80 | (c>>6 & 0x3F)); out[2] = char (0x80 | (c & 0x3F));
+    return 3;
+  }
+  out[0] = char (0xF0 | c>>18); out[1] = char (0x80 | (c>>12 & 0x3F));
+  out[2] = char (0x80 | (c>>6 & 0x3F)); out[3] = char (0x80 | (c & 0x3F));
+  return 4;
+}
+
+class code_points {
+    const char* next;
+    const char* last;
+    char32_t block[64];
+    // decodes the next block, and returns the number of code points in it
+    int refill () {return decode_block (next, last, block, 64);}
+  public:
+    code_points (const string& text) : next (text.data()), last (text.data() + text.size()) {}
+    class iterator {
+        code_points* range;
+        const char32_t* current;       // nullptr when the text is exhausted
+        const char32_t* stop;
+      public:
+        iterator (code_points* r, int count) : range (r), current (count ? r->block : nullptr), stop (r->block + count) {}
+        char32_t operator* () const {return *current;}
+        iterator& operator++ ()
+        {
+          if (++current == stop) *this = iterator (range, range->refill());
+          return *this;
+        }
+        bool operator!= (const iterator& other) const {return current != other.current;}
+    };
+    iterator begin () {return iterator (this, refill());}
+    iterator end () {return iterator (this, 0);}
+};
+
+string make_corpus (const char* sample, size_t size)
+{
+  string corpus;
+  while (corpus.size() < size) corpus += sample;
+  return corpus;
+}
+
+int main ()
+{
+  string str {"\xC2\xA1Hola, \xE4\xB8\x96\xE7\x95\x8C!"};     // "¡Hola, 世界!" in UTF-8
+  for (char c : str)
+  {
+    cout << "[" << c << "]";
+  }
+  cout << '\n';
+  if (valid_utf8 (str.data(), str.size()))
+    for (char32_t c : code_points (str))
+    {
+      char bytes[4];
+      cout << "[";
+      cout.write (bytes, encode (c, bytes));
+      cout << "]";
+    }
+  cout << '\n';
+  const char* invalid[] = {"\xC0\xAF", "\xED\xA0\x80", "\xF4\x90\x80\x80", "\xE4\xB8"};
+  for (int i=0; i<4; i++)
+    cout << (valid_utf8 (invalid[i], strlen (invalid[i])) ? "valid " : "invalid ");
+  cout << '\n';
+
+  const char* samples[] = {
+    "The quick brown fox jumps over the lazy dog, and then runs away into the forest. ",
+    "El ping\xC3\xBC" "ino Wenceslao hizo kil\xC3\xB3metros bajo exhaustiva lluvia y fr\xC3\xAD" "o, a\xC3\xB1or"
+    "aba a su querido cachorro. Voix ambigu\xC3\xAB d'un c\xC5\x93ur qui au z\xC3\xA9phyr pr\xC3\xA9" "f\xC3\xA8re. ",
+    "\xE6\x97\xA5\xE6\x9C\xAC\xE8\xAA\x9E\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xE3\x81\xA8\xE4\xB8\xAD\xE6\x96"
+    "\x87\xE3\x81\xAE\xE6\x96\x87\xE7\xAB\xA0\xEF\xBC\x8C\xE8\xBF\x99\xE6\x98\xAF\xE6\xB5\x8B\xE8\xAF\x95\xE3"
+    "\x80\x82 "
+  };
+  const char* names[] = {"ASCII:", "Latin:", "CJK:  "};
+  const size_t size = 1<<24;
+  const int rounds = 10;
+  for (int t=0; t<3; t++) {
+    string corpus = make_corpus (samples[t], size);
+    bool valid = true;
+    const char* volatile data = corpus.data();       // so that the validation is not done only once
+    auto start = chrono::steady_clock::now();
+    for (int r=0; r<rounds; r++)
+      valid = valid_utf8 (data, corpus.size()) && valid;
+    chrono::duration<double> validate_time = chrono::steady_clock::now() - start;
+
+    uint64_t sum = 0, count = 0;
+    start = chrono::steady_clock::now();
+    for (int r=0; r<rounds; r++)
+      for (char32_t c : code_points (corpus)) {
+        sum += c;
+        count++;
+      }
+    chrono::duration<double> decode_time = chrono::steady_clock::now() - start;
+
+    double gigabytes = double (corpus.size()) * rounds / 1e9;
+    cout << names[t] << (valid ? " valid" : " invalid") << ", validate " << gigabytes / validate_time.count()
+         << " GB/s, decode " << gigabytes / decode_time.count() << " GB/s ("
+         << double (corpus.size()) * rounds / count << " bytes per code point, checksum " << sum % 1000 << ")\n";
+  }
+  return 0;
+}
+/*Output (the timings depend on the machine):
+[�][�][H][o][l][a][,][ ][�][�][�][�][�][�][!]
+[¡][H][o][l][a][,][ ][世][界][!]
+invalid invalid invalid invalid
+
+The four invalid sequences are an overlong '/', a surrogate, a value above U+10FFFF and a sequence cut short.
+
+Notice the iterator of code_points: it points to the current code point in the block, and when it reaches the
+end of the block, it asks the range to decode the next one. All its copies share the same block, so it is
+enough for a range-based for loop, which only uses *, ++ and !=, but the loop can only go over the text once,
+and the text must stay alive during the loop. The end iterator holds a null pointer, as does any iterator once
+the text is exhausted.
+
+Validation is fastest on ASCII text, where most blocks are skipped, but the other two are not much slower: the
+blocks are checked in the same time whatever characters they have. Decoding, instead, goes through the text one
+sequence at a time, and the more non-ASCII characters the text has, the more time it spends in the table.
+
+Also notice that the first and the last block are copied to the array window before they are checked: the loop
+of invalid_block reads the 3 bytes before the block and all 32 bytes of it, which would be outside the text. The
+zeros around them are ASCII, so they never make a sequence valid. When the text ends exactly at the end of a
+block, though, there are no zeros after it, so the last 3 bytes are also checked for a sequence cut short.*/
@@ -0,0 +1,292 @@
+/* Faster factorials
+The recursive factorial function of the previous example calls itself a times to calculate a!,
+and it can only calculate up to 12! where a long has 32 bits (as in Windows). A long long has at
+least 64 bits everywhere, and goes up to 20!, but 21! = 51090942171709440000 does not fit in it
+anymore. The multiplication overflows and the result is garbage.
+
+Since there are only 21 factorials that fit in a long long, they can all be calculated by the
+compiler and stored in an array. A function declared constexpr can be evaluated while compiling
+when its arguments are constant expressions, so the same recursive function can be used to
+fill the table:
+
+constexpr long long cfactorial (long long a)
+{
+  return a > 1 ? a * cfactorial (a-1) : 1;
+}
+
+constexpr long long factorial_table[21] = { cfactorial (0), cfactorial (1), ... };
+
+Then, calculating a factorial at runtime is just reading one element of the array.
+
+Binomial coefficients, C(n,k) = n! / (k! (n-k)!), are used a lot with factorials, but calculating
+them with the formula overflows very soon: 21! is already too big, while C(67,33) still fits in
+an unsigned long long. Instead, they are calculated once with the Pascal triangle,
+C(n,k) = C(n-1,k-1) + C(n-1,k), and kept in a table that is built the first time it is needed.
+
+For larger numbers, an integer type able to grow is needed. The type bignum below is a vector of
+32-bit "digits" (limbs), the least significant first. Multiplying two numbers of n limbs the way
+it is taught at school takes n*n multiplications. The Karatsuba method splits each number in two
+halves, a = a1*B+a0 and b = b1*B+b0, and uses only three products instead of four:
+
+a*b = z2*B*B + (z1-z2-z0)*B + z0, with z2 = a1*b1, z0 = a0*b0, z1 = (a1+a0)*(b1+b0)
+
+Applied recursively, this takes about n^1.58 multiplications. To take advantage of it, the
+factorial is not calculated as 1*2*3*...*n, where one of the numbers is always small, but by
+binary splitting: the product of the numbers from lo to hi is the product of the first half times
+the product of the second half, so most of the work is done multiplying numbers of similar size.*/
+
+// fast factorials
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <algorithm>
+#include <stdexcept>
+#include <stdint.h>
+using namespace std;
+
+constexpr long long cfactorial (long long a)
+{
+  return a > 1 ? a * cfactorial (a-1) : 1;
+}
+
+constexpr long long factorial_table[21] = {
+  cfactorial (0), cfactorial (1), cfactorial (2), cfactorial (3), cfactorial (4),
+  cfactorial (5), cfactorial (6), cfactorial (7), cfactorial (8), cfactorial (9),
+  cfactorial (10), cfactorial (11), cfactorial (12), cfactorial (13), cfactorial (14),
+  cfactorial (15), cfactorial (16), cfactorial (17), cfactorial (18), cfactorial (19),
+  cfactorial (20)
+};
+
+// throws out_of_range unless a is between 0 and 20; use big_factorial for bigger numbers
+long long factorial (long a)
+{
+  if (a < 0 || a > 20) throw out_of_range ("factorial: only 0! to 20! fit in a long long");
+  return factorial_table[a];
+}
+
+class pascal_triangle {
+    unsigned long long rows[68][68];
+  public:
+    pascal_triangle ()
+    {
+      for (int n=0; n<68; n++) {
+        rows[n][0] = rows[n][n] = 1;
+        for (int k=1; k<n; k++)
+          rows[n][k] = rows[n-1][k-1] + rows[n-1][k];
+        for (int k=n+1; k<68; k++)
+          rows[n][k] = 0;
+      }
+    }
+    unsigned long long get (int n, int k) const {return rows[n][k];}
+};
+
+// throws out_of_range unless n is between 0 and 67
+unsigned long long binomial (int n, int k)
+{
+  static const pascal_triangle table;
+  if (n < 0 || n > 67) throw out_of_range ("binomial: n must be between 0 and 67");
+  if (k < 0 || k > n) return 0;
+  return table.get (n, k);
+}
+
+typedef vector<uint32_t> bignum;
+
+void trim (bignum& a)
+{
+  while (!a.empty() && a.back()==0) a.pop_back();
+}
+
+bignum add (const bignum& a, const bignum& b)
+{
+  const bignum& big = a.size() >= b.size() ? a : b;
+  const bignum& small = a.size() >= b.size() ? b : a;
+  bignum r (big.size()+1);
+  uint64_t carry = 0;
+  for (size_t i=0; i<big.size(); i++) {
+    carry += uint64_t(big[i]) + (i < small.size() ? small[i] : 0);
+    r[i] = uint32_t(carry);
+    carry >>= 32;
+  }
+  r[big.size()] = uint32_t(carry);
+  trim (r);
+  return r;
+}
+
+// a -= b, a must not be smaller than b
+void subtract (bignum& a, const bignum& b)
+{
+  int64_t borrow = 0;
+  for (size_t i=0; i<a.size(); i++) {
+    borrow += int64_t(a[i]) - (i < b.size() ? b[i] : 0);
+    a[i] = uint32_t(borrow);
+    borrow = borrow < 0 ? -1 : 0;
+  }
+  trim (a);
+}
+
+// r += a * B^shift, where B is 2^32
+void add_shifted (bignum& r, const bignum& a, size_t shift)
+{
+  if (r.size() < a.size()+shift+1) r.resize (a.size()+shift+1);
+  uint64_t carry = 0;
+  size_t i = 0;
+  for (; i<a.size(); i++) {
+    carry += uint64_t(r[i+shift]) + a[i];
+    r[i+shift] = uint32_t(carry);
+    carry >>= 32;
+  }
+  for (; carry && i+shift<r.size(); i++) {
+    carry += r[i+shift];
+    r[i+shift] = uint32_t(carry);
+    carry >>= 32;
+  }
+}
+
+bignum schoolbook_multiply (const bignum& a, const bignum& b)
+{
+  bignum r (a.size()+b.size());
+  for (size_t i=0; i<a.size(); i++) {
+    uint64_t carry = 0;
+    for (size_t j=0; j<b.size(); j++) {
+      carry += uint64_t(a[i]) * b[j] + r[i+j];
+      r[i+j] = uint32_t(carry);
+      carry >>= 32;
+    }
+    r[i+b.size()] = uint32_t(carry);
+  }
+  trim (r);
+  return r;
+}
+
+bignum multiply (const bignum& a, const bignum& b)
+{
+  if (a.size() < 48 || b.size() < 48)
+    return schoolbook_multiply (a, b);
+
+  size_t half = (max (a.size(), b.size()) + 1) / 2;
+  bignum a0 (a.begin(), a.begin() + min (half, a.size()));
+  bignum a1 (a.begin() + min (half, a.size()), a.end());
+  bignum b0 (b.begin(), b.begin() + min (half, b.size()));
+  bignum b1 (b.begin() + min (half, b.size()), b.end());
+  trim (a0); trim (b0);
+
+  bignum z0 = multiply (a0, b0);
+  bignum z2 = multiply (a1, b1);
+  bignum z1 = multiply (add (a0, a1), add (b0, b1));
+  subtract (z1, z0);
+  subtract (z1, z2);
+
+  bignum r;
+  add_shifted (r, z0, 0);
+  add_shifted (r, z1, half);
+  add_shifted (r, z2, 2*half);
+  trim (r);
+  return r;
+}
+
+// a *= m
+void multiply_small (bignum& a, uint32_t m)
+{
+  uint64_t carry = 0;
+  for (size_t i=0; i<a.size(); i++) {
+    carry += uint64_t(a[i]) * m;
+    a[i] = uint32_t(carry);
+    carry >>= 32;
+  }
+  if (carry) a.push_back (uint32_t(carry));
+}
+
+// product of all the numbers from lo to hi-1
+bignum product (uint32_t lo, uint32_t hi)
+{
+  if (hi - lo <= 16) {
+    bignum r (1, 1);
+    for (uint32_t i=lo; i<hi; i++)
+      multiply_small (r, i);
+    return r;
+  }
+  uint32_t mid = lo + (hi-lo)/2;
+  return multiply (product (lo, mid), product (mid, hi));
+}
+
+bignum big_factorial (uint32_t n)
+{
+  return n < 2 ? bignum (1, 1) : product (2, n+1);
+}
+
+bignum naive_factorial (uint32_t n)
+{
+  bignum r (1, 1);
+  for (uint32_t i=2; i<=n; i++)
+    multiply_small (r, i);
+  return r;
+}
+
+string to_string (bignum a)
+{
+  string digits;
+  do {
+    uint64_t rest = 0;
+    for (size_t i=a.size(); i-- > 0; ) {
+      rest = (rest << 32) | a[i];
+      a[i] = uint32_t(rest / 10);
+      rest %= 10;
+    }
+    digits.insert (digits.begin(), char('0' + rest));
+    trim (a);
+  } while (!a.empty());
+  return digits;
+}
+
+int main ()
+{
+  long number = 8;
+  cout << number << "! = " << factorial (number) << '\n';
+  cout << "20! = " << factorial (20) << '\n';
+  cout << "C(67,33) = " << binomial (67, 33) << '\n';
+  cout << "30! = " << to_string (big_factorial (30)) << '\n';
+  try {
+    long long f = factorial (21);
+    cout << "21! = " << f << '\n';
+  }
+  catch (out_of_range& e) {
+    cout << e.what() << ", 21! = " << to_string (big_factorial (21)) << '\n';
+  }
+
+  long long check = 0;
+  auto start = chrono::steady_clock::now();
+  for (int i=0; i<100000000; i++)
+    check ^= factorial (i % 21);
+  chrono::duration<double,nano> table = chrono::steady_clock::now() - start;
+  cout << "table factorial: " << table.count()/1e8 << " ns (" << check << ")\n";
+
+  for (uint32_t n=10; n<=100000; n*=10) {
+    start = chrono::steady_clock::now();
+    bignum fast = big_factorial (n);
+    chrono::duration<double,milli> split = chrono::steady_clock::now() - start;
+    start = chrono::steady_clock::now();
+    bignum slow = naive_factorial (n);
+    chrono::duration<double,milli> naive = chrono::steady_clock::now() - start;
+    cout << n << "!: " << fast.size() << " limbs, binary splitting " << split.count()
+         << " ms, one by one " << naive.count() << " ms" << (fast==slow ? "" : " (mismatch!)") << '\n';
+  }
+  return 0;
+}
+/*Output (the timings depend on the machine):
+8! = 40320
+20! = 2432902008176640000
+C(67,33) = 14226520737620288370
+30! = 265252859812191058636308480000000
+factorial: only 0! to 20! fit in a long long, 21! = 51090942171709440000
+
+Notice how the table of binomial coefficients is declared inside the function binomial as a static
+local variable. It is constructed only once, the first time the function is called, and then it is
+kept for the rest of the program. Since C++11 this initialization is also safe when the function is
+called from several threads at the same time.
+
+The array factorial_table, on the other hand, is declared constexpr, so its 21 elements are computed
+by the compiler and no time at all is spent calculating them when the program runs. Reading the table
+with a number outside it would read whatever is in memory after it, so factorial and binomial check their
+arguments first and throw out_of_range, from the header <stdexcept>; the caller can then use big_factorial,
+as main does for 21!.*/
@@ -0,0 +1,141 @@
+/* Working with blocks of values
+The odd and even functions of the example about declaring functions classify one number each
+time they are called: they call each other until one of them finds the answer, and then they
+write a sentence with cout. This is fine for a number typed by the user, but when the numbers
+come from a file with millions of them, the calls and, above all, the output, take much more
+time than the test itself.
+
+The test itself is very simple: the last bit of an integer is 1 for odd numbers and 0 for even
+numbers (also for negative numbers, which are stored in two's complement). So (x&1) is the
+parity of x, without any division and without any if.
+
+The functions below receive a whole block of integers through a pointer and the number of
+elements, like the arrays passed as parameters seen before. count_odd adds up the last bits, and
+parity_bitmap packs them into an array of 64-bit integers, one bit per number, so that 64 numbers
+take the space of just one. count_odd does exactly the same operations for every element, so the
+compiler can translate its loop into vector instructions that test several integers at the same time.
+
+parity_bitmap is harder: shifting each bit to a different position, word |= (x&1) << j, needs a
+different shift for each element, which the basic vector instructions of x86-64 cannot do, so that
+loop stays scalar. Instead, it first writes the 64 parities of a block as 64 bytes of value 0 or 1,
+a loop that is vectorized, and then gathers each 8 of those bytes into 8 bits with one multiplication:
+read as a 64-bit integer, byte k is multiplied by 2 to the power 56-7k, among others, which moves its
+bit to position 56+k, and the other products never reach bits 56 to 63, so shifting right by 56 leaves
+the 8 bits in order.
+
+The interactive program becomes a thin wrapper: each number typed is a block of one element.*/
+
+// parity of blocks of integers
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <cstring>
+#include <stdint.h>
+using namespace std;
+
+long count_odd (const int* values, int n)
+{
+  long odd = 0;
+  for (int i=0; i<n; i++)
+    odd += values[i] & 1;
+  return odd;
+}
+
+// true on processors that keep the lowest byte of an integer first in memory, such as x86 and ARM
+inline bool little_endian ()
+{
+  uint16_t one = 1;
+  unsigned char first;
+  memcpy (&first, &one, 1);
+  return first == 1;
+}
+
+// the parities of count<=64 values as the bits of a word, one at a time
+uint64_t parity_word (const int* values, int count)
+{
+  uint64_t word = 0;
+  for (int j=0; j<count; j++)
+    word |= uint64_t(values[j] & 1) << j;
+  return word;
+}
+
+// bit i of bits[i/64] is set when values[i] is odd
+void parity_bitmap (const int* values, int n, uint64_t* bits)
+{
+  int i = 0;
+  if (little_endian ())
+    for (; i+64 <= n; i+=64) {
+      unsigned char parity[64];
+      for (int j=0; j<64; j++)
+        parity[j] = (unsigned char) (values[i+j] & 1);
+      uint64_t word = 0;
+      for (int k=0; k<8; k++) {
+        uint64_t eight;
+        memcpy (&eight, parity + 8*k, 8);
+        word |= ((eight * 0x0102040810204080u) >> 56) << (8*k);
+      }
+      bits[i/64] = word;
+    }
+  for (; i<n; i+=64)
+    bits[i/64] = parity_word (values + i, n-i < 64 ? n-i : 64);
+}
+
+void benchmark ()
+{
+  const int block = 1<<16;
+  const long total = 1000000000;
+  vector<int> values (block);
+  vector<uint64_t> bits (block/64);
+  for (int i=0; i<block; i++)
+    values[i] = i*7 + (i>>3);
+
+  long odd = 0;
+  auto start = chrono::steady_clock::now();
+  for (long done=0; done<total; done+=block)
+    odd += count_odd (values.data(), block);
+  chrono::duration<double> counting = chrono::steady_clock::now() - start;
+  cout << "count_odd:     " << odd << " odd, " << counting.count() << " s for about 10^9 integers\n";
+
+  uint64_t check = 0;
+  start = chrono::steady_clock::now();
+  for (long done=0; done<total; done+=block) {
+    parity_bitmap (values.data(), block, bits.data());
+    check ^= bits[done/block % bits.size()];
+  }
+  chrono::duration<double> bitmap = chrono::steady_clock::now() - start;
+  cout << "parity_bitmap: " << bitmap.count() << " s for about 10^9 integers (" << check << ")\n";
+}
+
+int main (int argc, char* argv[])
+{
+  if (argc > 1 && string (argv[1]) == "benchmark") {
+    benchmark ();
+    return 0;
+  }
+  int i;
+  do {
+    cout << "Please, enter number (0 to exit): ";
+    if (!(cin >> i)) break;
+    if (count_odd (&i, 1)) cout << "It is odd.\n";
+    else cout << "It is even.\n";
+  } while (i!=0);
+  return 0;
+}
+/*Run the program with the argument benchmark to classify about 10^9 integers instead of reading them:
+
+./7_bulk_parity benchmark
+
+Notice that the benchmark does not keep 10^9 integers in memory, which would take 4 GB: it classifies
+the same block of 65536 integers again and again. Reading and classifying data in blocks of a fixed
+size is the usual way of working with streams that are too big to fit in memory. parity_bitmap, with
+its vectorized loop and the multiplications, is about as fast as count_odd; building each word one bit
+at a time, as parity_word does for the last block, would make it about four times slower.
+
+The multiplication depends on the order of the bytes in memory: on a processor that keeps the highest
+byte first, the bits of each group of 8 would come out reversed. little_endian checks it, and such a
+processor uses parity_word for every block. The compiler knows the answer when it compiles the program,
+so the check costs nothing.
+
+The old version used both odd and even to answer one question. Now both answers come from the same
+function, and printing the sentence is the only work left that depends on the number being odd or even.*/
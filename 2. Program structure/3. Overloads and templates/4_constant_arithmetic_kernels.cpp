@@ -0,0 +1,165 @@
+/* Arithmetic by constants over arrays
+In the previous example fixed_multiply multiplies a single value by the template argument N.
+The same idea can be applied to a whole array, and to other operations with a constant: divide
+and modulo. These are the operations used, for example, to place values in N buckets:
+
+bucket = value % N;
+
+Integer division is one of the slowest instructions of a processor: it takes tens of cycles,
+while a multiplication takes three or four. But dividing by a constant d can be done with a
+multiplication by a "magic number" m close to 2^32/d, followed by some shifts. For an unsigned
+32-bit value n, with l the number of bits needed to hold d-1:
+
+m = 2^32 * (2^l - d) / d + 1
+t = (m * n) >> 32
+q = (t + ((n - t) >> 1)) >> (l - 1)
+
+gives exactly q = n / d for every n (with the shifts adjusted when d is 1). When d is a template
+argument, m and l are computed by the compiler itself, since the functions that compute them are
+declared constexpr. In fact, compilers already do this same transformation on their own whenever
+they see a division by a literal value, such as val / 7.
+
+The interesting case is when the divisor is not known until the program runs, for example when
+the number of buckets is read from a configuration file. Then the compiler has to emit a real
+division instruction. The class divider below computes m and the shifts once, when it is
+constructed, and then each division is just a multiplication, an addition and two shifts. This
+is how libraries such as libdivide work. */
+
+// arithmetic by constants
+#include <iostream>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+#include <stdint.h>
+using namespace std;
+
+// number of bits needed to represent d-1
+constexpr unsigned log2_ceil (uint32_t d, unsigned l = 0)
+{
+  return (uint64_t(1) << l) >= d ? l : log2_ceil (d, l+1);
+}
+
+class divider {
+    uint32_t magic;
+    unsigned shift1, shift2;
+    uint32_t d;
+  public:
+    constexpr divider (uint32_t divisor)
+      : magic (uint32_t((uint64_t(1) << 32) * ((uint64_t(1) << log2_ceil (divisor)) - divisor) / divisor + 1)),
+        shift1 (log2_ceil (divisor) < 1 ? log2_ceil (divisor) : 1),
+        shift2 (log2_ceil (divisor) < 1 ? 0 : log2_ceil (divisor) - 1),
+        d (divisor) {}
+    constexpr uint32_t divide (uint32_t n) const
+    {
+      return (uint32_t((uint64_t(magic) * n) >> 32) + ((n - uint32_t((uint64_t(magic) * n) >> 32)) >> shift1)) >> shift2;
+    }
+    constexpr uint32_t modulo (uint32_t n) const
+    {
+      return n - divide (n) * d;
+    }
+};
+
+template <class T, int N>
+T fixed_multiply (T val)
+{
+  return val * N;
+}
+
+template <class T, int N>
+void fixed_multiply (const T* in, T* out, int n)
+{
+  for (int i=0; i<n; i++)
+    out[i] = in[i] * N;
+}
+
+template <uint32_t N>
+void fixed_divide (const uint32_t* in, uint32_t* out, int n)
+{
+  constexpr divider d (N);
+  for (int i=0; i<n; i++)
+    out[i] = d.divide (in[i]);
+}
+
+template <uint32_t N>
+void fixed_modulo (const uint32_t* in, uint32_t* out, int n)
+{
+  constexpr divider d (N);
+  for (int i=0; i<n; i++)
+    out[i] = d.modulo (in[i]);
+}
+
+void divide (const uint32_t* in, uint32_t* out, int n, const divider& d)
+{
+  for (int i=0; i<n; i++)
+    out[i] = d.divide (in[i]);
+}
+
+void modulo (const uint32_t* in, uint32_t* out, int n, const divider& d)
+{
+  for (int i=0; i<n; i++)
+    out[i] = d.modulo (in[i]);
+}
+
+int main (int argc, char* argv[]) {
+  uint32_t values[5] = {0, 6, 7, 100, 4294967295u};
+  uint32_t result[5];
+  fixed_divide<7> (values, result, 5);
+  for (int i=0; i<5; i++) cout << result[i] << ' ';
+  cout << '\n';
+  fixed_modulo<7> (values, result, 5);
+  for (int i=0; i<5; i++) cout << result[i] << ' ';
+  cout << '\n';
+  fixed_multiply<uint32_t,3> (values, result, 5);
+  for (int i=0; i<5; i++) cout << result[i] << ' ';
+  cout << '\n';
+
+  // the number of buckets is only known when the program runs
+  uint32_t buckets = 1001;
+  if (argc > 1) buckets = strtoul (argv[1], 0, 10);
+  if (buckets == 0) buckets = 1;
+  divider d (buckets);
+
+  const int n = 1<<16, rounds = 2000;
+  vector<uint32_t> in (n), out (n);
+  for (int i=0; i<n; i++)
+    in[i] = uint32_t(i) * 2654435761u;
+
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      out[i] = in[i] % buckets;
+  chrono::duration<double,nano> hardware = chrono::steady_clock::now() - start;
+  uint32_t check = out[n-1];
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    modulo (in.data(), out.data(), n, d);
+  chrono::duration<double,nano> runtime = chrono::steady_clock::now() - start;
+  if (out[n-1] != check) cout << "divider gave a different result!\n";
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    fixed_modulo<1001> (in.data(), out.data(), n);
+  chrono::duration<double,nano> fixed = chrono::steady_clock::now() - start;
+
+  double total = double(n) * rounds;
+  cout << "ns per modulo\n";
+  cout << "% operator:         " << hardware.count()/total << '\n';
+  cout << "divider:            " << runtime.count()/total << '\n';
+  cout << "fixed_modulo<1001>: " << fixed.count()/total << '\n';
+  return 0;
+}
+/*Output (the timings depend on the machine):
+0 0 1 14 613566756
+0 6 0 2 3
+0 18 21 300 4294967293
+
+Notice how the constructor of divider and its member functions are declared constexpr. This allows the
+same class to be used in both ways: in fixed_divide, the object d is a constant expression, so its magic
+number is calculated while compiling and the program only contains the multiplication; in main, the
+object d is built from a value that is only known at runtime, and then the very same code calculates
+it when the program runs. Here the number of buckets can be given as the first argument of the program,
+and it is 1001 by default.
+
+The multiplication by a constant does not need anything special: the compiler already replaces val * N
+by the cheapest combination of shifts and additions, such as (val << 3) + val for N equal to 9.*/
@@ -0,0 +1,218 @@
+/* Choosing the algorithm from the type
+The function template sum of the function templates example adds two values of any type T.
+Adding all the values of an array looks like the same problem, but the best way of doing it
+depends on the type:
+
+- For integers, the total can be much bigger than any of the values: the sum of a million
+  ints easily overflows an int. The total has to be kept in a wider type, long long.
+
+- For floating point numbers, every addition is rounded, and when a small value is added to a
+  big total, most of its digits are lost. Adding ten million times 0.1f to a float gives about
+  1087937 instead of 1000000. The Kahan-Babuska-Neumaier method keeps a second variable with the
+  part that was lost in the rounding of each addition, and adds it at the end.
+
+- For any other type, such as the CVector class of the overloading operators example, we can
+  only rely on its operator +, starting from a default-constructed value.
+
+The standard header <type_traits> provides class templates such as is_integral<T> and
+is_floating_point<T>, whose member value is true or false depending on T, known at compile time.
+They can be used as template arguments to select a different specialization of a class template.
+Here, the class template accumulator has one specialization for each case.
+
+Big arrays can also be added by several threads at the same time. But with floating point numbers,
+(a+b)+c is not always exactly equal to a+(b+c), so if each thread added a different part of the
+array, the result would change with the number of threads. To avoid it, the array is always split in
+the same blocks of 32768 elements, no matter how many threads there are. Each block is added on its
+own, and then the partial sums are combined in the order of the blocks. The threads only decide who
+adds each block, which does not change the result.*/
+
+// sum of ranges
+#include <iostream>
+#include <type_traits>
+#include <thread>
+#include <vector>
+#include <chrono>
+#include <cmath>
+using namespace std;
+
+template <class T>
+T sum (T a, T b)
+{
+  T result;
+  result = a + b;
+  return result;
+}
+
+template <class T, bool integral = is_integral<T>::value, bool floating = is_floating_point<T>::value>
+class accumulator {
+    T total;
+  public:
+    typedef T result_type;
+    accumulator () : total () {}
+    void add (const T& x) {total = total + x;}
+    void merge (const accumulator& other) {add (other.total);}
+    result_type result () const {return total;}
+};
+
+template <class T>
+class accumulator <T,true,false> {
+  public:
+    typedef typename conditional<is_signed<T>::value, long long, unsigned long long>::type result_type;
+  private:
+    result_type total;
+  public:
+    accumulator () : total (0) {}
+    void add (T x) {total += x;}
+    void merge (const accumulator& other) {total += other.total;}
+    result_type result () const {return total;}
+};
+
+template <class T>
+class accumulator <T,false,true> {
+    T total, lost;
+  public:
+    typedef T result_type;
+    accumulator () : total (0), lost (0) {}
+    void add (T x)
+    {
+      T t = total + x;
+      if (fabs (total) >= fabs (x)) lost += (total - t) + x;
+      else lost += (x - t) + total;
+      total = t;
+    }
+    void merge (const accumulator& other)
+    {
+      add (other.total);
+      lost += other.lost;
+    }
+    result_type result () const {return total + lost;}
+};
+
+const long block_size = 32768;
+
+// with threads 0 (or less), uses one thread per processor
+template <class T>
+typename accumulator<T>::result_type sum (const T* first, const T* last, int threads)
+{
+  if (threads <= 0) threads = int (thread::hardware_concurrency());
+  if (threads <= 0) threads = 1;       // hardware_concurrency returns 0 when it cannot tell
+  long n = last - first;
+  long blocks = (n + block_size - 1) / block_size;
+  vector<accumulator<T> > partial (blocks);
+
+  auto add_blocks = [&] (int thread) {
+    for (long b=thread; b<blocks; b+=threads) {
+      const T* end = b == blocks-1 ? last : first + (b+1)*block_size;
+      // a local accumulator, stored once per block: the partial sums of neighboring blocks share cache lines,
+      // and writing them on every element would make the threads fight for them
+      accumulator<T> block;
+      for (const T* p = first + b*block_size; p != end; ++p)
+        block.add (*p);
+      partial[b] = block;
+    }
+  };
+
+  vector<thread> workers;
+  for (int t=1; t<threads; t++)
+    workers.push_back (thread (add_blocks, t));
+  add_blocks (0);
+  for (size_t t=0; t<workers.size(); t++)
+    workers[t].join();
+
+  accumulator<T> total;
+  for (long b=0; b<blocks; b++)
+    total.merge (partial[b]);
+  return total.result();
+}
+
+class CVector {
+  public:
+    int x,y;
+    CVector () : x(0), y(0) {}
+    CVector (int a, int b) : x(a), y(b) {}
+};
+
+CVector operator+ (const CVector& lhs, const CVector& rhs) {
+  return CVector (lhs.x + rhs.x, lhs.y + rhs.y);
+}
+
+template <class T>
+void benchmark (const char* name, const vector<T>& values)
+{
+  const int rounds = 20;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++) {
+    T plain = T();
+    for (size_t i=0; i<values.size(); i++)
+      plain = sum (plain, values[i]);
+    volatile T keep = plain;
+    (void) keep;
+  }
+  chrono::duration<double,milli> loop = chrono::steady_clock::now() - start;
+  cout << name << ": loop with sum(a,b) " << loop.count()/rounds << " ms";
+
+  for (int threads=1; threads<=4; threads*=2) {
+    start = chrono::steady_clock::now();
+    for (int r=0; r<rounds; r++)
+      sum (values.data(), values.data() + values.size(), threads);
+    chrono::duration<double,milli> elapsed = chrono::steady_clock::now() - start;
+    cout << ", " << threads << " threads " << elapsed.count()/rounds << " ms";
+  }
+  cout << '\n';
+}
+
+int main () {
+  int i=5, j=6, k;
+  k=sum<int>(i,j);
+  cout << k << '\n';
+
+  // accuracy: ten million times 0.1f
+  vector<float> tenths (10000000, 0.1f);
+  float naive = 0;
+  for (size_t n=0; n<tenths.size(); n++)
+    naive += tenths[n];
+  cout << "float loop: " << naive << '\n';
+  cout << "float sum:  " << sum (tenths.data(), tenths.data() + tenths.size(), 1) << '\n';
+
+  // the result does not depend on the number of threads
+  vector<double> values (3000000);
+  for (size_t n=0; n<values.size(); n++)
+    values[n] = 1.0 / (n+1) * (n%2 ? -1 : 1) * 1e10;
+  for (int threads=0; threads<=8; threads = threads ? threads*2 : 1)
+    if (sum (values.data(), values.data() + values.size(), threads) !=
+        sum (values.data(), values.data() + values.size(), 1))
+      cout << "the result changed with " << threads << " threads!\n";
+
+  vector<int> ints (3000000, 2000);
+  cout << "int sum: " << sum (ints.data(), ints.data() + ints.size(), 4) << '\n';
+  vector<CVector> vectors (3000000, CVector (3,1));
+  CVector total = sum (vectors.data(), vectors.data() + vectors.size(), 4);
+  cout << "CVector sum: " << total.x << ',' << total.y << '\n';
+
+  vector<int> small (3000000);
+  for (size_t n=0; n<small.size(); n++)
+    small[n] = n%100;
+  benchmark ("int", small);
+  benchmark ("double", values);
+  return 0;
+}
+/*Output (the timings depend on the machine and the number of processors):
+11
+float loop: 1.08794e+06
+float sum:  1e+06
+int sum: 6000000000
+CVector sum: 9000000,3000000
+
+Compile it with the option -pthread in GCC and Clang. Do not use options such as -ffast-math: they allow
+the compiler to assume that floating point additions are associative, and then it may simplify the
+compensation away, since with exact arithmetic (total - t) + x is always zero.
+
+Notice how the same name, sum, is now used for two function templates: one with parameters (T a, T b)
+and one with parameters (const T* first, const T* last, int threads). The number of threads has no default
+value on purpose: sum (p, q) with two pointers p and q would then match both templates, and the compiler
+would choose the first one, which needs no conversion of the pointers to const, and try to add them. To let
+the function choose, pass 0: sum (p, q, 0) uses as many threads as thread::hardware_concurrency() reports.
+
+Also notice the return type of the second one: typename accumulator<T>::result_type. It is long long
+for an int, unsigned long long for an unsigned int, and the same T for the rest. The keyword typename is
+needed because, until T is known, the compiler cannot know whether result_type is a type or a value.*/
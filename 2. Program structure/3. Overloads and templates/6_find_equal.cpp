@@ -0,0 +1,216 @@
+/* Searching with two template parameters
+The function template are_equal of the function templates example compares two values that
+can be of different types, are_equal<int,double>(10,10.0). Searching an array for a value is
+just calling it for every element until it returns true, and that is what std::find, from the
+header <algorithm>, does.
+
+When both types are different, each comparison first converts the element to the wider type:
+a short is converted to int to be compared with an int key, a float is converted to double to
+be compared with a double key. But the same question can be answered the other way around. If
+the key converted to the element type and back gives the same key, only elements equal to that
+converted key can match. If it does not, for example the key 100000 and elements of type short,
+or the key 0.1 and elements of type float, nothing in the array can be equal to it and there is
+no need to look at it at all. In both cases, the elements are compared without converting them,
+which allows twice as many shorts as ints to be compared by the same vector instruction.
+
+(This only works when both types are integers of the same signedness, or both are floating point
+types. Comparing a signed with an unsigned value, or an integer with a floating point value, has
+rules of its own, so in those cases each element is converted, exactly like are_equal does.)
+
+find_equal also avoids stopping after each element: it counts the matches in a block of 32
+elements, without any branch inside the block, and only when the count is not zero it goes back
+over that block, one element at a time, to find the first match. A loop that just adds up the
+results of the comparisons is one that compilers vectorize, with the basic vector instructions
+that every x86-64 processor has.*/
+
+// searching with mixed types
+#include <iostream>
+#include <algorithm>
+#include <type_traits>
+#include <limits>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+template <class T, class U>
+bool are_equal (T a, U b)
+{
+  return (a==b);
+}
+
+// true when key can be compared as a T without changing the result
+template <class T, class U>
+struct same_kind {
+  static const bool value =
+    (is_integral<T>::value && is_integral<U>::value && is_signed<T>::value == is_signed<U>::value) ||
+    (is_floating_point<T>::value && is_floating_point<U>::value);
+};
+
+// converts key to T in narrow, and returns true, if it has the same value as a T; converting a value outside the
+// range of T, such as 1e300 to float, would be undefined behavior, so the range is checked first
+template <class T, class U>
+bool narrow_key (U key, T& narrow)
+{
+  typedef typename common_type<T,U>::type C;      // the wider of both types
+  bool infinite = numeric_limits<T>::has_infinity &&
+                  (C(key) == C(numeric_limits<T>::infinity()) || C(key) == -C(numeric_limits<T>::infinity()));
+  if (!infinite && (C(key) < C(numeric_limits<T>::lowest()) || C(key) > C(numeric_limits<T>::max()))) return false;
+  narrow = T(key);
+  return are_equal (narrow, key);
+}
+
+// number of elements equal to key among the 32 elements at first
+template <class T, class K>
+int count_block (const T* first, K key)
+{
+  int hits = 0;
+  for (int j=0; j<32; j++)
+    hits += are_equal (first[j], key);
+  return hits;
+}
+
+// bit j of the result is set when first[j] equals key, for the n<=32 first elements
+template <class T, class K>
+uint32_t match_mask (const T* first, int n, K key)
+{
+  uint32_t mask = 0;
+  for (int j=0; j<n; j++)
+    mask |= uint32_t(are_equal (first[j], key)) << j;
+  return mask;
+}
+
+template <class T, class K>
+const T* find_equal_as (const T* first, const T* last, K key)
+{
+  for (; last-first >= 32; first += 32)
+    if (count_block (first, key)) break;      // the match is in this block: the loop below finds it
+  for (; first != last; ++first)
+    if (are_equal (*first, key)) return first;
+  return last;
+}
+
+template <class T, class K>
+long count_equal_as (const T* first, const T* last, K key)
+{
+  long count = 0;
+  for (; first != last; ++first)
+    count += are_equal (*first, key);
+  return count;
+}
+
+template <class T, class K>
+void match_bitmap_as (const T* first, const T* last, K key, uint32_t* bits)
+{
+  for (long i=0; first+i < last; i+=32) {
+    int n = last-first-i < 32 ? int(last-first-i) : 32;
+    bits[i/32] = match_mask (first+i, n, key);
+  }
+}
+
+// returns a pointer to the first element equal to key, or last if there is none
+template <class T, class U>
+const T* find_equal (const T* first, const T* last, U key)
+{
+  if (same_kind<T,U>::value) {
+    T narrow;
+    if (!narrow_key (key, narrow)) return last;
+    return find_equal_as (first, last, narrow);
+  }
+  return find_equal_as (first, last, key);
+}
+
+// returns the number of elements equal to key
+template <class T, class U>
+long count_equal (const T* first, const T* last, U key)
+{
+  if (same_kind<T,U>::value) {
+    T narrow;
+    if (!narrow_key (key, narrow)) return 0;
+    return count_equal_as (first, last, narrow);
+  }
+  return count_equal_as (first, last, key);
+}
+
+// sets bit i%32 of bits[i/32] when first[i] is equal to key
+template <class T, class U>
+void match_bitmap (const T* first, const T* last, U key, uint32_t* bits)
+{
+  if (same_kind<T,U>::value) {
+    T narrow;
+    if (!narrow_key (key, narrow)) {
+      fill (bits, bits + (last-first+31)/32, 0);
+      return;
+    }
+    match_bitmap_as (first, last, narrow, bits);
+    return;
+  }
+  match_bitmap_as (first, last, key, bits);
+}
+
+template <class T, class U>
+void benchmark (const char* name, const vector<T>& values, U value)
+{
+  const int rounds = 200;
+  volatile U key = value;   // read again on every round, so that no search is skipped
+  const T* first = values.data();
+  const T* last = first + values.size();
+  long found = 0;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    found += find (first, last, key) - first;
+  chrono::duration<double,micro> standard = chrono::steady_clock::now() - start;
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    found -= find_equal (first, last, key) - first;
+  chrono::duration<double,micro> ours = chrono::steady_clock::now() - start;
+  cout << name << ": std::find " << standard.count()/rounds << " us, find_equal "
+       << ours.count()/rounds << " us" << (found ? " (different results!)" : "") << '\n';
+}
+
+int main ()
+{
+  short shorts[] = {5, -3, 10, 7, 10};
+  float floats[] = {0.5f, 0.1f, 2.0f};
+  cout << find_equal (shorts, shorts+5, 10) - shorts << '\n';
+  cout << count_equal (shorts, shorts+5, 10) << '\n';
+  cout << find_equal (shorts, shorts+5, 100000) - shorts << '\n';
+  cout << find_equal (floats, floats+3, 2.0) - floats << '\n';
+  cout << find_equal (floats, floats+3, 0.1) - floats << '\n';
+  cout << find_equal (floats, floats+3, 1e300) - floats << '\n';
+
+  const int n = 1<<20;
+  vector<short> values16 (n);
+  vector<float> values32 (n);
+  for (int i=0; i<n; i++) {
+    values16[i] = short(i % 30000);
+    values32[i] = float(i % 30000) + 0.25f;
+  }
+  values16[n-10] = -1;
+  values32[n-10] = -1;
+  benchmark ("int16 array, int key", values16, -1);
+  benchmark ("float array, double key", values32, -1.0);
+  return 0;
+}
+/*Output (the timings depend on the machine; compile with optimizations, -O2 is enough for GCC 12 or later):
+2
+2
+5
+2
+3
+3
+
+The key 100000 does not fit in a short, so find_equal returns last (position 5) without looking at the array.
+The key 0.1 is not found either, even if it looks like the second element: 0.1 cannot be represented exactly
+in binary, and the float closest to it, 0.1f, is a different value than the double closest to it, 0.1.
+are_equal(0.1f, 0.1) is also false. The key 1e300 is too big for a float, and narrow_key rejects it before
+converting it, which would be undefined behavior.
+
+Notice that find_equal, count_equal and match_bitmap all use the same struct same_kind to decide whether the
+key can be narrowed. Its member value is a static const bool initialized with a constant expression, so the
+condition of each if is known at compile time, and the compiler removes the branch that is never taken.
+
+Also notice that count_block counts the matches instead of building a mask like match_mask does: shifting each
+result to its own bit makes every step of the loop depend on the previous one, and compilers do not vectorize
+that with the basic instructions, while a sum is split among the lanes of a vector and added up at the end. The
+bitmap still needs match_mask, since the position of each match is what it stores.*/
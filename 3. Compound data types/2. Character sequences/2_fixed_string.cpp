@@ -0,0 +1,231 @@
+/*Strings of fixed capacity
+In the previous example, answer1 is an array of 80 chars, and cin >> answer1 writes into it all the characters
+of the word typed by the user, whatever its length: a word of 100 characters writes past the end of the array,
+over whatever is stored after it in memory. A string does not have this problem, because it grows as needed,
+but growing means allocating memory, and a string that has grown keeps its characters in another block of
+memory, so an array of strings cannot be copied, or written to a file, as a single block of bytes.
+
+The class template fixed_string keeps the characters inside the object, like the array, together with their
+number. Its capacity N is a template parameter, so each fixed_string has the same size, known at compile time,
+and is never allocated anywhere but where the object itself is: on the stack, or inside a structure or an array.
+
+template <size_t N>
+class fixed_string {
+    char chars[N+1];          // up to N characters and the terminating null character
+    unsigned char length;
+  ...
+};
+
+The operator >> of fixed_string reads a word like the one for arrays of chars, but it never reads more than N
+characters: if the word is longer, it stops and sets the failbit of the stream, so the program can know that
+the word was too long, with the same test as for any other failed read.
+
+fixed_string has no pointers, and no copy constructor, assignment or destructor of its own: copying it just
+copies its bytes. Such a type is called trivially copyable, and the standard allows copying its objects (or an
+array of them) with memcpy, and writing them to a binary file and reading them back as they are.*/
+
+// fixed capacity strings
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <cctype>
+#include <cstdio>
+#include <type_traits>
+#include <chrono>
+#if __cplusplus >= 201703L
+#include <string_view>
+#endif
+using namespace std;
+
+template <size_t N>
+class fixed_string {
+    static_assert (N < 256, "the length of a fixed_string is kept in an unsigned char");
+    char chars[N+1];
+    unsigned char length;
+  public:
+    fixed_string () : length (0) {memset (chars, 0, N+1);}
+    fixed_string (const char* text) {assign (text, strlen (text));}
+    fixed_string (const string& text) {assign (text.data(), text.size());}
+    // copies at most N characters, and returns false if text had to be cut; the unused chars are set to zero,
+    // so that the bytes of two equal fixed_strings are equal, in memory and in files
+    bool assign (const char* text, size_t n)
+    {
+      bool fits = n <= N;
+      if (!fits) n = N;
+      memcpy (chars, text, n);
+      memset (chars+n, 0, N+1-n);
+      length = (unsigned char) n;
+      return fits;
+    }
+    bool push_back (char c)
+    {
+      if (length == N) return false;
+      chars[length++] = c;
+      chars[length] = '\0';
+      return true;
+    }
+    void clear () {length = 0; memset (chars, 0, N+1);}
+    size_t size () const {return length;}
+    static constexpr size_t capacity () {return N;}
+    const char* data () const {return chars;}
+    const char* c_str () const {return chars;}
+    string str () const {return string (chars, length);}
+#if __cplusplus >= 201703L
+    operator string_view () const {return string_view (chars, length);}
+#endif
+    bool operator== (const fixed_string& other) const
+    {
+      return length == other.length && memcmp (chars, other.chars, length) == 0;
+    }
+    bool operator!= (const fixed_string& other) const {return !(*this == other);}
+};
+
+template <size_t N>
+ostream& operator<< (ostream& out, const fixed_string<N>& s)
+{
+  return out.write (s.data(), s.size());
+}
+
+// reads a word of at most N characters, and sets failbit if it is longer
+template <size_t N>
+istream& operator>> (istream& in, fixed_string<N>& s)
+{
+  istream::sentry skip_whitespace (in);
+  if (!skip_whitespace) return in;
+  s.clear();
+  int c;
+  while ((c = in.peek()) != EOF && !isspace (c)) {
+    if (!s.push_back (char (c))) {
+      in.setstate (ios::failbit);
+      return in;
+    }
+    in.get();
+  }
+  if (c == EOF) in.setstate (ios::eofbit);
+  return in;
+}
+
+// a short-string-heavy record, in both versions
+struct person {
+  string name;
+  string city;
+  string country;
+  int age;
+};
+
+struct fixed_person {
+  fixed_string<31> name;
+  fixed_string<23> city;
+  fixed_string<15> country;
+  int age;
+};
+
+static_assert (is_trivially_copyable<fixed_person>::value, "fixed_person must be copyable with memcpy");
+
+void benchmark ()
+{
+  const char* names[] = {"Alice", "Bob", "Carol Ann Smith", "Dave", "Eve", "Frank Lloyd Wright", "Grace", "Heidi"};
+  const char* cities[] = {"Paris", "Tokyo", "New York", "Lima", "Saint Petersburg", "Oslo", "Nairobi", "Rome"};
+  const char* countries[] = {"France", "Japan", "USA", "Peru", "Russia", "Norway", "Kenya", "Italy"};
+  const int n = 1000000, rounds = 5;
+  vector<person> people (n);
+  vector<fixed_person> fixed_people (n);
+  for (int i=0; i<n; i++) {
+    people[i].name = names[i%8];
+    people[i].city = cities[i*3%8];
+    people[i].country = countries[i*3%8];
+    people[i].age = 20 + i%60;
+    fixed_people[i].name = names[i%8];
+    fixed_people[i].city = cities[i*3%8];
+    fixed_people[i].country = countries[i*3%8];
+    fixed_people[i].age = 20 + i%60;
+  }
+
+  vector<person> people_copy;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    people_copy = people;
+  chrono::duration<double,milli> copy_strings = chrono::steady_clock::now() - start;
+
+  vector<fixed_person> fixed_copy (n);
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    memcpy (fixed_copy.data(), fixed_people.data(), n * sizeof(fixed_person));
+  chrono::duration<double,milli> copy_fixed = chrono::steady_clock::now() - start;
+
+  // writing to a binary file: each string has to be written field by field, with its length
+  start = chrono::steady_clock::now();
+  {
+    ofstream file ("people.bin", ios::binary);
+    for (int i=0; i<n; i++) {
+      const string* fields[3] = {&people[i].name, &people[i].city, &people[i].country};
+      for (int f=0; f<3; f++) {
+        unsigned char length = (unsigned char) fields[f]->size();
+        file.write ((const char*) &length, 1);
+        file.write (fields[f]->data(), length);
+      }
+      file.write ((const char*) &people[i].age, sizeof(int));
+    }
+  }
+  chrono::duration<double,milli> write_strings = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  {
+    ofstream file ("people.bin", ios::binary);
+    file.write ((const char*) fixed_people.data(), n * sizeof(fixed_person));
+  }
+  chrono::duration<double,milli> write_fixed = chrono::steady_clock::now() - start;
+
+  vector<fixed_person> loaded (n);
+  ifstream ("people.bin", ios::binary).read ((char*) loaded.data(), n * sizeof(fixed_person));
+  remove ("people.bin");
+  if (loaded[n-1].name != fixed_people[n-1].name || people_copy[n-1].name != fixed_copy[n-1].name.str())
+    cout << "the copies are different\n";
+
+  cout << "sizeof(person) " << sizeof(person) << ", sizeof(fixed_person) " << sizeof(fixed_person) << '\n';
+  cout << "copy:  strings " << copy_strings.count()/rounds << " ms, fixed " << copy_fixed.count()/rounds << " ms\n";
+  cout << "write: strings " << write_strings.count() << " ms, fixed " << write_fixed.count() << " ms\n";
+}
+
+int main (int argc, char* argv[])
+{
+  if (argc > 1 && string (argv[1]) == "benchmark") {
+    benchmark ();
+    return 0;
+  }
+  char question1[] = "What is your name? ";
+  string question2 = "Where do you live? ";
+  fixed_string<79> answer1;
+  string answer2;
+  cout << question1;
+  if (!(cin >> answer1)) {
+    cout << "That name is too long, the first " << answer1.capacity() << " characters will do.\n";
+    cin.clear();
+    cin.ignore (1000, '\n');
+  }
+  cout << question2;
+  cin >> answer2;
+  cout << "Hello, " << answer1;
+  cout << " from " << answer2 << "!\n";
+  return 0;
+}
+/*Run the program with the argument benchmark to compare a million records with strings and with fixed_strings:
+
+./2_fixed_string benchmark
+
+Copying the vector of records with strings has to copy each string separately (and allocate memory for the
+ones that do not fit in the string object itself), while the fixed records are copied with a single memcpy.
+Writing them to a file is similar: each string has to be written with its length, since its characters are
+not inside the record, but the fixed records are written as they are in memory.
+
+The price of fixed_string is the unused space: each record takes the maximum size of its members, whatever
+their length. And a file written this way can only be read by a program with the same layout of fixed_person,
+compiled for a system with the same byte order.
+
+Notice the sentry object in operator>>. Constructing a sentry of an input stream skips the whitespace before the
+next word, as the other >> operators do, and converts to false if the stream cannot be read.
+
+When the program is compiled for C++17 or later, fixed_string can also be converted to a string_view, a class
+of the header <string_view> that refers to characters stored somewhere else, without copying them.*/
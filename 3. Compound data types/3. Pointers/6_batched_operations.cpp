@@ -0,0 +1,120 @@
+/*Pointers to functions as template arguments
+In the pointers to functions example, operation receives a pointer to the function to call, and
+calls it through that pointer. When operation is used for millions of pairs of values, there is a
+call through a pointer for each pair: the compiler cannot know which function will be called, so it
+can neither replace the call by the body of the function (inline it) nor process several pairs at once.
+
+The choice of the function, though, is usually made only once for all the pairs. So it is better to
+call through a pointer only once, to a function that processes the whole arrays. A pointer to a
+function can also be a non-type template argument, like the int N of fixed_multiply:
+
+template <int (*functocall)(int,int)>
+void operation (const int* x, const int* y, int* result, int n);
+
+Each instantiation, such as operation<addition>, is a different function in which the function to
+call is known at compile time, so its loop is compiled as if it contained the expression x[i]+y[i]
+itself, and the compiler can use vector instructions that add several pairs at the same time.
+
+What remains is choosing the right instantiation from a value known only at runtime, such as an
+operation code read from a file. An array of pointers to the instantiations, indexed by the code, does
+it with a single indirect call for the whole arrays.*/
+
+// batched operations
+#include <iostream>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+int addition (int a, int b)
+{ return (a+b); }
+
+int subtraction (int a, int b)
+{ return (a-b); }
+
+int multiplication (int a, int b)
+{ return (a*b); }
+
+int operation (int x, int y, int (*functocall)(int,int))
+{
+  int g;
+  g = (*functocall)(x,y);
+  return (g);
+}
+
+template <int (*functocall)(int,int)>
+void operation (const int* x, const int* y, int* result, int n)
+{
+  for (int i=0; i<n; i++)
+    result[i] = functocall (x[i], y[i]);
+}
+
+enum op_code { op_addition, op_subtraction, op_multiplication };
+
+void (* const batch_table[])(const int*, const int*, int*, int) = {
+  operation<addition>,
+  operation<subtraction>,
+  operation<multiplication>
+};
+
+const int op_count = sizeof batch_table / sizeof batch_table[0];
+
+// op is an int, not an op_code, since it can come from outside the program with any value;
+// returns false, and does nothing, if it is not the code of an operation
+bool operation (int op, const int* x, const int* y, int* result, int n)
+{
+  if (op < 0 || op >= op_count) return false;
+  batch_table[op] (x, y, result, n);
+  return true;
+}
+
+int main ()
+{
+  int x[4] = {7, 20, 3, 10};
+  int y[4] = {5, 12, 4, -10};
+  int result[4];
+  operation (op_subtraction, x, y, result, 4);
+  for (int i=0; i<4; i++) cout << result[i] << ' ';
+  cout << '\n';
+  if (!operation (7, x, y, result, 4)) cout << "7 is not an operation\n";
+
+  const int n = 1<<16, rounds = 2000;
+  vector<int> xs (n), ys (n), rs (n);
+  for (int i=0; i<n; i++) {
+    xs[i] = i;
+    ys[i] = n-i;
+  }
+  int (* const single_table[])(int,int) = {addition, subtraction, multiplication};
+  volatile int code = op_subtraction;   // as if it was read from a file
+
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++) {
+    int (*functocall)(int,int) = single_table[code];
+    for (int i=0; i<n; i++)
+      rs[i] = operation (xs[i], ys[i], functocall);
+  }
+  chrono::duration<double,nano> single = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    operation (code, xs.data(), ys.data(), rs.data(), n);
+  chrono::duration<double,nano> batch = chrono::steady_clock::now() - start;
+
+  cout << "one call per pair: " << single.count()/(double(n)*rounds) << " ns per pair\n";
+  cout << "one call per batch: " << batch.count()/(double(n)*rounds) << " ns per pair\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+2 8 -1 20
+7 is not an operation
+
+Notice the declaration of batch_table: it is an array of constant pointers to functions with four parameters
+(const int*, const int*, int*, int) that return void. Its size is not specified, so it is taken from the
+number of initializers, and its elements are the addresses of three different instantiations of the same
+function template.
+
+The name operation is now used by three functions: the original one, the function template and the function
+that takes an operation code. This is valid because they differ in their parameters, as explained for overloaded
+functions.
+
+Also notice that the code is checked before indexing batch_table: with a code outside the array, the program
+would read whatever is in memory after it and call it as a function.*/
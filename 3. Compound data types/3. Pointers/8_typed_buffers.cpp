@@ -0,0 +1,138 @@
+/*Describing the data behind a void pointer
+The increase function of the void pointers example receives a void pointer and the size of the
+pointed data, and uses the size to decide whether it points to a char or to an int. That decision
+is taken again for every value, and only two sizes are known: a short, a long long, a float or a
+double cannot be increased, and a float has the same size as an int, so the size alone is not
+enough to know the type.
+
+When a whole buffer of values of the same type has to be increased, it is better to describe it
+once with a small struct: the address of the first value, the type of the values (an enumerated
+type), how many values there are and the distance in bytes from one value to the next (the stride).
+The stride is usually the size of the type, but it can be larger, for example to increase only one
+member of each element of an array of structures.
+
+The type is then checked only once per buffer, in a switch that calls an instantiation of the
+function template increase_all for the right type. Inside it, the type is known at compile time,
+and when the values are contiguous the loop is the simplest possible one, so the compiler can use
+vector instructions that increase 16 chars, or 8 shorts, or 4 ints at the same time.*/
+
+// typed buffers
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+void increase (void* data, int psize)
+{
+  if ( psize == sizeof(char) )
+  { char* pchar; pchar=(char*)data; ++(*pchar); }
+  else if (psize == sizeof(int) )
+  { int* pint; pint=(int*)data; ++(*pint); }
+}
+
+enum element_type { int8, int16, int32, int64, float32, float64 };
+
+struct buffer {
+  void* data;
+  element_type type;
+  long count;
+  long stride;     // in bytes
+};
+
+template <class T>
+void increase_all (void* data, long count, long stride)
+{
+  if (stride == sizeof(T)) {
+    T* values = (T*) data;
+    for (long i=0; i<count; i++)
+      ++values[i];
+  }
+  else {
+    char* bytes = (char*) data;
+    for (long i=0; i<count; i++)
+      ++*(T*)(bytes + i*stride);
+  }
+}
+
+void increase (const buffer& b)
+{
+  switch (b.type) {
+    case int8:    increase_all<int8_t> (b.data, b.count, b.stride); break;
+    case int16:   increase_all<int16_t> (b.data, b.count, b.stride); break;
+    case int32:   increase_all<int32_t> (b.data, b.count, b.stride); break;
+    case int64:   increase_all<int64_t> (b.data, b.count, b.stride); break;
+    case float32: increase_all<float> (b.data, b.count, b.stride); break;
+    case float64: increase_all<double> (b.data, b.count, b.stride); break;
+  }
+}
+
+struct point {
+  double x, y;
+  int hits;
+};
+
+int main ()
+{
+  char a[3] = {'x', 'a', 'L'};
+  double d[2] = {1.5, 2.25};
+  point points[2] = {{0.5, 1.0, 3}, {2.0, 4.0, 7}};
+  buffer ba = {a, int8, 3, sizeof(char)};
+  buffer bd = {d, float64, 2, sizeof(double)};
+  buffer bp = {&points[0].hits, int32, 2, sizeof(point)};
+  increase (ba);
+  increase (bd);
+  increase (bp);
+  cout << a[0] << a[1] << a[2] << ", " << d[0] << ' ' << d[1] << ", "
+       << points[0].hits << ' ' << points[1].hits << '\n';
+
+  const int n = 1<<16, rounds = 2000;
+  vector<int> ints (n);
+  vector<char> chars (n);
+  buffer bints = {ints.data(), int32, n, sizeof(int)};
+  buffer bchars = {chars.data(), int8, n, sizeof(char)};
+  // as if the sizes and the buffers were only known at runtime
+  volatile int int_size = sizeof(int), char_size = sizeof(char);
+  void (* volatile increase_buffer)(const buffer&) = increase;
+
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      increase (&ints[i], int_size);
+  chrono::duration<double,nano> one_int = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    increase_buffer (bints);
+  chrono::duration<double,nano> all_ints = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      increase (&chars[i], char_size);
+  chrono::duration<double,nano> one_char = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    increase_buffer (bchars);
+  chrono::duration<double,nano> all_chars = chrono::steady_clock::now() - start;
+
+  double total = double(n) * rounds;
+  cout << "int:  increase(void*,int) " << one_int.count()/total << " ns, increase(buffer) "
+       << all_ints.count()/total << " ns per value (" << ints[0] << ")\n";
+  cout << "char: increase(void*,int) " << one_char.count()/total << " ns, increase(buffer) "
+       << all_chars.count()/total << " ns per value (" << int(chars[0]) << ")\n";
+  return 0;
+}
+/*Output (the timings depend on the machine; compile with -O3 to let the compiler vectorize increase_all):
+ybM, 2.5 3.25, 4 8
+
+Notice the third buffer, bp: it points to the member hits of the first point, and its stride is the size of
+a whole point, so increase only modifies the hits of each point, and leaves x and y untouched.
+
+In the benchmark, increase(buffer) is called through a volatile pointer to function. Otherwise the compiler,
+which sees that bints always holds ints, would remove the switch, and the test would not show the cost of
+choosing the type at runtime.
+
+The types int8_t, int16_t, int32_t and int64_t are defined in the header <stdint.h> (or <cstdint>), and are
+integer types of exactly 8, 16, 32 and 64 bits. Unlike int or long, their size is the same on every system.*/
@@ -0,0 +1,278 @@
+/*Interning strings
+The structures movies_t and friends_t of the previous example keep their title, name and email in members of
+type string. In a large catalog, most of these strings are repeated many times: thousands of friends have the
+same favorite movie, and most emails end with one of a few domains. Each string member keeps its own copy of
+the characters (with the usual implementations, short strings are stored inside the string object itself,
+which is already 32 bytes long, and longer ones in memory allocated elsewhere).
+
+Interning keeps a single copy of each different string in a table, and gives it a number, called a symbol.
+The structures then keep the symbols instead of the strings: 4 bytes each, and comparing two of them is
+comparing two integers. The table gives the string of a symbol back when it is needed, for example to print it.
+
+struct movies_t {
+  symbol title;
+  int year;
+};
+
+The table below is a hash table: the hash of the string tells where to look for it. If the catalog is loaded
+by several threads at the same time, they all need to use the table, and a table protected by a single mutex
+would let only one of them work at a time. So the table is split in 64 independent parts, called shards, each
+one with its own mutex, and some bits of the hash choose the shard of each string: two threads only wait for
+each other when their strings fall in the same shard. The symbol holds the number of the shard in its lowest
+6 bits, and the position of the string inside the shard in the others.
+
+Each shard keeps its strings in a deque. Unlike a vector, a deque never moves its elements when it grows,
+so the reference to a string returned by the table stays valid forever, even while other threads add strings.*/
+
+// string interning
+#include <iostream>
+#include <string>
+#include <vector>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <stdint.h>
+using namespace std;
+
+// counts the bytes currently allocated with new, by every thread
+atomic<long> allocated (0);
+
+void* operator new (size_t size)
+{
+  size_t* p = (size_t*) malloc (size + 16);
+  if (p == nullptr) throw bad_alloc();
+  *p = size;
+  allocated.fetch_add (long (size), memory_order_relaxed);
+  return (char*) p + 16;
+}
+
+void operator delete (void* p) noexcept
+{
+  if (p == nullptr) return;
+  size_t* block = (size_t*) ((char*) p - 16);
+  allocated.fetch_sub (long (*block), memory_order_relaxed);
+  free (block);
+}
+
+// the other forms of new and delete must also use the header, or they would free the wrong address
+void operator delete (void* p, size_t) noexcept {operator delete (p);}
+void* operator new[] (size_t size) {return operator new (size);}
+void operator delete[] (void* p) noexcept {operator delete (p);}
+void operator delete[] (void* p, size_t) noexcept {operator delete (p);}
+
+typedef uint32_t symbol;
+
+class symbol_table {
+    static const int shard_bits = 6;
+    static const int shards = 1 << shard_bits;
+    struct shard {
+      mutex lock;
+      deque<string> strings;
+      vector<uint32_t> slots;        // position in strings + 1, or 0 if empty
+      shard () : slots (64, 0) {}
+    };
+    shard table[shards];
+
+    static uint64_t hash (const string& text)
+    {
+      uint64_t h = 14695981039346656037u;
+      for (size_t i=0; i<text.size(); i++)
+        h = (h ^ (unsigned char) text[i]) * 1099511628211u;
+      return h ^ (h >> 29);
+    }
+    // the slot where text is, or the empty slot where it should be
+    static uint32_t& find (shard& s, const string& text, uint64_t h)
+    {
+      size_t mask = s.slots.size() - 1;
+      for (size_t i = (h >> shard_bits) & mask; ; i = (i+1) & mask)
+        if (s.slots[i] == 0 || s.strings[s.slots[i]-1] == text)
+          return s.slots[i];
+    }
+    static void grow (shard& s)
+    {
+      vector<uint32_t> old (s.slots.size() * 2, 0);
+      old.swap (s.slots);
+      for (size_t i=0; i<old.size(); i++)
+        if (old[i])
+          find (s, s.strings[old[i]-1], hash (s.strings[old[i]-1])) = old[i];
+    }
+  public:
+    symbol intern (const string& text)
+    {
+      uint64_t h = hash (text);
+      shard& s = table[h & (shards-1)];
+      lock_guard<mutex> guard (s.lock);
+      uint32_t& slot = find (s, text, h);
+      uint32_t position = slot;
+      if (position == 0) {
+        s.strings.push_back (text);
+        position = slot = uint32_t (s.strings.size());
+        if (s.strings.size() * 2 > s.slots.size()) grow (s);      // slot is not valid after this
+      }
+      return symbol (((position-1) << shard_bits) | (h & (shards-1)));
+    }
+    const string& name (symbol sym)
+    {
+      shard& s = table[sym & (shards-1)];
+      lock_guard<mutex> guard (s.lock);
+      return s.strings[sym >> shard_bits];
+    }
+    size_t size ()
+    {
+      size_t total = 0;
+      for (int i=0; i<shards; i++) {
+        lock_guard<mutex> guard (table[i].lock);
+        total += table[i].strings.size();
+      }
+      return total;
+    }
+};
+
+symbol_table symbols;
+
+// the structures of the previous example
+struct movies_t {
+  string title;
+  int year;
+};
+
+struct friends_t {
+  string name;
+  string email;
+  movies_t favorite_movie;
+};
+
+// the same structures, with symbols; the email is split at the @, so that domains are shared
+struct interned_movies_t {
+  symbol title;
+  int year;
+};
+
+struct interned_friends_t {
+  symbol name;
+  symbol user, domain;
+  interned_movies_t favorite_movie;
+};
+
+// generates the fields of entry i of a catalog with realistic repetitions
+const char* first_names[] = {"Charlie", "Maria", "James", "Ana", "John", "Laura", "Peter", "Sofia",
+                             "David", "Elena", "Paul", "Clara", "Mark", "Julia", "Louis", "Emma"};
+const char* last_names[] = {"Smith", "Garcia", "Brown", "Lopez", "Miller", "Martin", "Wilson", "Moore",
+                            "Taylor", "Thomas", "White", "Harris", "Clark", "Lewis", "Walker", "Young"};
+const char* adjectives[] = {"Blade", "Silent", "Dark", "Lost", "Last", "Red", "Hidden", "Broken"};
+const char* nouns[] = {"Runner", "River", "Empire", "Island", "Mountain", "Garden", "Kingdom", "Road",
+                       "Night", "Heart", "Storm", "City", "Ocean", "Forest", "Star", "Door"};
+const char* domains[] = {"gmail.com", "yahoo.com", "hotmail.com", "outlook.com", "icloud.com", "aol.com",
+                         "mail.com", "protonmail.com", "gmx.net", "yandex.ru", "web.de", "example.org"};
+
+uint64_t mix (uint64_t x)
+{
+  x = (x ^ (x >> 31)) * 0x7fb5d329728ea185u;
+  x = (x ^ (x >> 27)) * 0x81dadef4bc2dd44du;
+  return x ^ (x >> 33);
+}
+
+void generate (long i, string& name, string& user, string& domain, string& title, int& year)
+{
+  uint64_t r = mix (uint64_t (i));
+  const char* first = first_names[r % 16];
+  const char* last = last_names[(r >> 4) % 16];
+  name = string (first) + ' ' + last;
+  user = string (first) + '.' + last + to_string ((r >> 8) % 1000);
+  uint64_t d = (r >> 20) % 64;
+  domain = domains[d * d / 342];                      // a few domains are much more common
+  uint64_t k = (r >> 32) % 4096;
+  k = k * k / 4096;                                   // and so are a few movies
+  title = string ("The ") + adjectives[k % 8] + ' ' + nouns[(k / 8) % 16];
+  if (k >= 128) title += ' ' + to_string (k / 128 + 1);
+  year = 1950 + int (k % 70);
+}
+
+void load_strings (vector<friends_t>& catalog, long begin, long end)
+{
+  string name, user, domain, title;
+  int year;
+  for (long i=begin; i<end; i++) {
+    generate (i, name, user, domain, title, year);
+    catalog[i].name = name;
+    catalog[i].email = user + '@' + domain;
+    catalog[i].favorite_movie.title = title;
+    catalog[i].favorite_movie.year = year;
+  }
+}
+
+void load_symbols (vector<interned_friends_t>& catalog, long begin, long end)
+{
+  string name, user, domain, title;
+  int year;
+  for (long i=begin; i<end; i++) {
+    generate (i, name, user, domain, title, year);
+    catalog[i].name = symbols.intern (name);
+    catalog[i].user = symbols.intern (user);
+    catalog[i].domain = symbols.intern (domain);
+    catalog[i].favorite_movie.title = symbols.intern (title);
+    catalog[i].favorite_movie.year = year;
+  }
+}
+
+int main (int argc, char* argv[])
+{
+  long entries = 50000000;
+  if (argc > 1) entries = atol (argv[1]);
+  int threads = thread::hardware_concurrency();
+  if (threads < 1) threads = 1;
+
+  // the catalog with strings is only built for its first entries, and its memory is extrapolated
+  long sample = entries < 2000000 ? entries : 2000000;
+  long before = allocated;
+  auto start = chrono::steady_clock::now();
+  vector<friends_t> strings (sample);
+  load_strings (strings, 0, sample);
+  chrono::duration<double> strings_time = chrono::steady_clock::now() - start;
+  double strings_bytes = double (allocated - before) / sample;
+  cout << strings[1].name << ", " << strings[1].email << ", " << strings[1].favorite_movie.title
+       << " (" << strings[1].favorite_movie.year << ")\n";
+  vector<friends_t>().swap (strings);
+
+  before = allocated;
+  start = chrono::steady_clock::now();
+  vector<interned_friends_t> catalog (entries);
+  vector<thread> loaders;
+  for (int t=0; t<threads; t++)
+    loaders.push_back (thread (load_symbols, ref (catalog), entries*t/threads, entries*(t+1)/threads));
+  for (int t=0; t<threads; t++)
+    loaders[t].join();
+  chrono::duration<double> symbols_time = chrono::steady_clock::now() - start;
+  double symbols_bytes = double (allocated - before) / entries;
+  const interned_friends_t& f = catalog[1];
+  cout << symbols.name (f.name) << ", " << symbols.name (f.user) << '@' << symbols.name (f.domain) << ", "
+       << symbols.name (f.favorite_movie.title) << " (" << f.favorite_movie.year << ")\n";
+
+  cout << entries << " entries, " << symbols.size() << " different strings\n";
+  cout << "strings: " << strings_bytes << " bytes per entry, " << strings_bytes * entries / 1e9
+       << " GB in total, " << strings_time.count() / sample * 1e9 << " ns per entry\n";
+  cout << "symbols: " << symbols_bytes << " bytes per entry, " << symbols_bytes * entries / 1e9
+       << " GB in total, " << symbols_time.count() / entries * 1e9 << " ns per entry with "
+       << threads << " threads\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+Emma Smith, Emma.Smith42@aol.com, The Silent Door (2001)
+Emma Smith, Emma.Smith42@aol.com, The Silent Door (2001)
+50000000 entries, 259340 different strings
+
+By default the catalog has 50 million entries, and a different size can be given as the first argument. The
+memory of the catalog with strings is measured on its first 2 million entries at most, since the whole catalog
+would need several gigabytes.
+
+Notice how the memory is measured: the program replaces the global operator new and operator delete, which
+are used by new, delete and all the standard containers, with versions that keep the size of each block in
+the 16 bytes before it, and add it to, or subtract it from, an atomic counter of the allocated bytes.
+
+Also notice that the member function find returns a reference to the slot: intern can then check whether it is
+empty, and write the position of the new string into it, without searching a second time. The reference is only
+valid until the vector of slots grows: grow replaces it with a larger one, so intern keeps a copy of the position
+and uses that copy to build the symbol.*/
@@ -0,0 +1,191 @@
+/*Byte order
+The union mix_t of the previous example lets us see the same 4 bytes as an int, as two shorts or
+as four chars. But which char is the most significant byte of the int depends on the system: on a
+little-endian system (such as x86 processors) c[0] is the least significant byte, and on a big-endian
+system it is the most significant one. The same happens with s.hi and s.lo.
+
+This matters as soon as the bytes come from outside the program: files and network protocols
+define their own byte order, and many of them (called "network byte order") use big-endian. Copying
+the bytes into a union and reading the int gives the right value on some systems and the wrong one
+on others.
+
+A way of reading data that works on every system is not to look at the order of the system at all,
+and build the value from its bytes with shifts. For a big-endian 32-bit value:
+
+value = (p[0] << 24) | (p[1] << 16) | (p[2] << 8) | p[3];
+
+This looks slow, but compilers recognize this pattern: on a big-endian system they replace it with
+a single load, and on a little-endian one with a load followed by a bswap instruction, which reverses
+the order of the bytes of a register.
+
+The class template field below describes one member of a record in a buffer of bytes: its type, its
+byte order and its offset from the beginning of the record, all known at compile time. Its static
+member functions get and set read and write it with the shifts above. Floating point and signed values
+are read as the unsigned integer of the same size and then copied bit by bit with memcpy, which is the
+safe way to reinterpret bytes as another type.
+
+To convert a whole array at once, byte_swap writes each element in little-endian order and reads it
+back in big-endian order, which reverses its bytes on any system. The compiler turns it into one bswap
+per element, or, with -O3 and a processor that has them, into vector instructions that shuffle the bytes
+of several elements at the same time.*/
+
+// byte order
+#include <iostream>
+#include <cstring>
+#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+enum byte_order { little_endian, big_endian };
+
+// unsigned integer type with the same size as T
+template <size_t size> struct unsigned_of;
+template <> struct unsigned_of<1> { typedef uint8_t type; };
+template <> struct unsigned_of<2> { typedef uint16_t type; };
+template <> struct unsigned_of<4> { typedef uint32_t type; };
+template <> struct unsigned_of<8> { typedef uint64_t type; };
+
+// reads and writes the first n bytes of p as an unsigned integer of type U
+template <class U, size_t n>
+struct bytes {
+  static U big (const unsigned char* p) {return U(bytes<U,n-1>::big (p) << 8) | p[n-1];}
+  static U little (const unsigned char* p) {return U(bytes<U,n-1>::little (p+1) << 8) | p[0];}
+  static void put_big (unsigned char* p, U v) {p[n-1] = (unsigned char) v; bytes<U,n-1>::put_big (p, U(v >> 8));}
+  static void put_little (unsigned char* p, U v) {p[0] = (unsigned char) v; bytes<U,n-1>::put_little (p+1, U(v >> 8));}
+};
+
+template <class U>
+struct bytes<U,0> {
+  static U big (const unsigned char*) {return 0;}
+  static U little (const unsigned char*) {return 0;}
+  static void put_big (unsigned char*, U) {}
+  static void put_little (unsigned char*, U) {}
+};
+
+template <class U, byte_order order>
+U load (const unsigned char* p)
+{
+  return order==big_endian ? bytes<U,sizeof(U)>::big (p) : bytes<U,sizeof(U)>::little (p);
+}
+
+template <class U, byte_order order>
+void store (unsigned char* p, U value)
+{
+  if (order==big_endian) bytes<U,sizeof(U)>::put_big (p, value);
+  else bytes<U,sizeof(U)>::put_little (p, value);
+}
+
+template <class T, byte_order order, size_t offset>
+struct field {
+  typedef typename unsigned_of<sizeof(T)>::type bits;
+  static T get (const unsigned char* record)
+  {
+    bits b = load<bits,order> (record + offset);
+    T value;
+    memcpy (&value, &b, sizeof(T));
+    return value;
+  }
+  static void set (unsigned char* record, T value)
+  {
+    bits b;
+    memcpy (&b, &value, sizeof(T));
+    store<bits,order> (record + offset, b);
+  }
+};
+
+template <class U>
+U swap_bytes (U x)
+{
+  unsigned char p[sizeof(U)];
+  bytes<U,sizeof(U)>::put_little (p, x);
+  return bytes<U,sizeof(U)>::big (p);
+}
+
+template <class U>
+void byte_swap (U* data, size_t n)
+{
+  for (size_t i=0; i<n; i++)
+    data[i] = swap_bytes (data[i]);
+}
+
+union mix_t {
+  int l;
+  struct {
+    short hi;
+    short lo;
+    } s;
+  char c[4];
+};
+
+// the same four bytes as mix_t, in network byte order
+struct wire_mix {
+  typedef field<int32_t, big_endian, 0> l;
+  typedef field<int16_t, big_endian, 0> hi;
+  typedef field<int16_t, big_endian, 2> lo;
+};
+
+int main ()
+{
+  unsigned char packet[4] = {0x12, 0x34, 0x56, 0x78};
+  mix_t mix;
+  memcpy (mix.c, packet, 4);
+  cout << hex << "union: " << mix.l << ' ' << mix.s.hi << ' ' << mix.s.lo << '\n';
+  cout << "field: " << wire_mix::l::get (packet) << ' '
+       << wire_mix::hi::get (packet) << ' ' << wire_mix::lo::get (packet) << dec << '\n';
+
+  unsigned char price[8];
+  field<double, big_endian, 0>::set (price, 3.75);
+  cout << field<double, big_endian, 0>::get (price) << '\n';
+
+  const size_t n = 1<<20;
+  const int rounds = 100;
+  vector<unsigned char> wire (4*n);
+  vector<unsigned> values (n);
+  for (size_t i=0; i<n; i++)
+    field<int32_t, big_endian, 0>::set (&wire[4*i], int32_t(i*2654435761u));
+
+  // union punning: copy the bytes in reverse order (correct only on little-endian systems)
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<n; i++) {
+      mix_t m;
+      for (int b=0; b<4; b++) m.c[b] = wire[4*i+3-b];
+      values[i] += m.l;
+    }
+  chrono::duration<double,nano> punning = chrono::steady_clock::now() - start;
+  unsigned check = values[n-1];
+  fill (values.begin(), values.end(), 0);
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<n; i++)
+      values[i] += field<int32_t, big_endian, 0>::get (&wire[4*i]);
+  chrono::duration<double,nano> fields = chrono::steady_clock::now() - start;
+  if (values[n-1] != check) cout << "field and union give different values\n";
+
+  vector<uint32_t> words (n);
+  memcpy (words.data(), wire.data(), 4*n);
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    byte_swap (words.data(), n);
+  chrono::duration<double,nano> swapped = chrono::steady_clock::now() - start;
+
+  double total = double(n) * rounds;
+  cout << "union:     " << punning.count()/total << " ns per value\n";
+  cout << "field:     " << fields.count()/total << " ns per value\n";
+  cout << "byte_swap: " << swapped.count()/total << " ns per value\n";
+  return 0;
+}
+/*Output on a little-endian system (the timings depend on the machine):
+union: 78563412 3412 7856
+field: 12345678 1234 5678
+3.75
+
+The union shows the bytes in the order of the system, while field always reads them in the order of
+the packet. On a big-endian system, both lines would be equal.
+
+Notice the struct unsigned_of: it is a class template that is only declared, and then specialized for the
+sizes 1, 2, 4 and 8. unsigned_of<sizeof(T)>::type is an unsigned type of the same size as T, and using it
+with a type of any other size is an error at compile time, since the generic template has no definition.*/
@@ -0,0 +1,193 @@
+/*Compact records with a tagged union
+The structures book1_t and book2_t of the first example reserve 50 chars for the title and 50 for the
+author of each book, although most titles and names are much shorter, so each book takes 104 bytes,
+most of them unused. And nothing in the structure says whether the price union currently holds dollars
+or yen: the program has to remember it somewhere else.
+
+The usual solution for the second problem is to add a member, called the tag (or discriminant), that
+tells which member of the union is active:
+
+enum currency_t : unsigned char {dollars, yen};
+
+struct book_t {
+  currency_t currency;
+  union {
+    float dollars;
+    int yen;
+  };
+};
+
+For the first problem, the characters of all the titles and authors can be stored one after the other
+in a single shared string, the heap, and each record keeps only where its text starts and how long it is.
+Short texts, such as "Emma" or "Dune", do not even need that: if they fit in the space that would hold
+their position in the heap, they are stored right there, inside the record. This is called small string
+optimization, and std::string does something similar.
+
+The class text_ref below takes 8 bytes: 2 for the length, and 6 that hold either the characters of a
+text of up to 6 characters, or the position (offset) of a longer one in the heap. With the tag and the
+union, a whole book takes 24 bytes, plus the characters of its long texts in the heap.
+
+Smaller records do not only save memory: a loop over all the books, such as adding their prices, has to
+bring four times fewer bytes from memory to the processor.*/
+
+// compact records
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstring>
+#include <chrono>
+#include <stdexcept>
+#include <stdint.h>
+using namespace std;
+
+enum currency_t : unsigned char {dollars, yen};
+
+// the structure of the first example, with a tag
+struct book_fixed {
+  char title[50];
+  char author[50];
+  currency_t currency;
+  union {
+    float dollars;
+    int yen;
+  } price;
+};
+
+class text_ref {
+    uint16_t length;
+    char chars[6];
+  public:
+    static const size_t max_inline = 6;
+    // throws length_error if the text does not fit in length, or its position in the heap in 4 bytes
+    text_ref (const string& text, string& heap)
+    {
+      if (text.size() > UINT16_MAX) throw length_error ("text_ref: text longer than 65535 characters");
+      if (text.size() > max_inline && heap.size() > UINT32_MAX) throw length_error ("text_ref: heap over 4 GB");
+      length = uint16_t(text.size());
+      if (text.size() <= max_inline)
+        memcpy (chars, text.data(), text.size());
+      else {
+        uint32_t offset = uint32_t(heap.size());
+        memcpy (chars, &offset, sizeof(offset));
+        heap += text;
+      }
+    }
+    size_t size () const {return length;}
+    const char* data (const string& heap) const
+    {
+      if (length <= max_inline) return chars;
+      uint32_t offset;
+      memcpy (&offset, chars, sizeof(offset));
+      return heap.data() + offset;
+    }
+};
+
+struct book_compact {
+  text_ref title;
+  text_ref author;
+  union {
+    float dollars;
+    int yen;
+  };
+  currency_t currency;
+};
+
+class book_store {
+    vector<book_compact> books;
+    string heap;
+  public:
+    void add (const string& title, const string& author, float price_in_dollars)
+    {
+      book_compact b = {text_ref (title, heap), text_ref (author, heap), {price_in_dollars}, dollars};
+      books.push_back (b);
+    }
+    void add (const string& title, const string& author, int price_in_yen)
+    {
+      book_compact b = {text_ref (title, heap), text_ref (author, heap), {0}, yen};
+      b.yen = price_in_yen;
+      books.push_back (b);
+    }
+    size_t size () const {return books.size();}
+    const book_compact& operator[] (size_t i) const {return books[i];}
+    string title (size_t i) const {return string (books[i].title.data (heap), books[i].title.size());}
+    string author (size_t i) const {return string (books[i].author.data (heap), books[i].author.size());}
+    const char* first_char_of_title (size_t i) const {return books[i].title.data (heap);}
+    size_t memory () const {return books.size()*sizeof(book_compact) + heap.size();}
+};
+
+int main ()
+{
+  const char* titles[] = {"Emma", "Dune", "It", "Ulysses", "The Hobbit", "Don Quixote", "Moby Dick", "Beloved"};
+  const char* authors[] = {"J. Austen", "F. Herbert", "S. King", "J. Joyce", "J.R.R. Tolkien", "Cervantes", "H. Melville", "Morrison"};
+  const size_t count = 1000000;
+
+  vector<book_fixed> fixed (count);
+  book_store store;
+  for (size_t i=0; i<count; i++) {
+    const char* title = titles[i*7%8];
+    const char* author = authors[i*7%8];
+    strcpy (fixed[i].title, title);
+    strcpy (fixed[i].author, author);
+    if (i%3) {
+      fixed[i].currency = dollars;
+      fixed[i].price.dollars = 9.5f + i%10;
+      store.add (title, author, 9.5f + i%10);
+    }
+    else {
+      fixed[i].currency = yen;
+      fixed[i].price.yen = 1200 + i%100;
+      store.add (title, author, int (1200 + i%100));
+    }
+  }
+  cout << store.title (4) << " by " << store.author (4) << '\n';
+  cout << "fixed:   " << sizeof(book_fixed) << " bytes per book\n";
+  cout << "compact: " << double (store.memory()) / store.size() << " bytes per book\n";
+
+  const int rounds = 20;
+  double total_dollars = 0;
+  long long total_yen = 0, titles_with_d = 0;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<count; i++) {
+      if (fixed[i].currency == dollars) total_dollars += fixed[i].price.dollars;
+      else total_yen += fixed[i].price.yen;
+      titles_with_d += fixed[i].title[0] == 'D';
+    }
+  chrono::duration<double,milli> fixed_time = chrono::steady_clock::now() - start;
+  cout << total_dollars << " dollars, " << total_yen << " yen, " << titles_with_d << " D\n";
+
+  total_dollars = 0;
+  total_yen = titles_with_d = 0;
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<count; i++) {
+      const book_compact& b = store[i];
+      if (b.currency == dollars) total_dollars += b.dollars;
+      else total_yen += b.yen;
+      titles_with_d += store.first_char_of_title (i)[0] == 'D';
+    }
+  chrono::duration<double,milli> compact_time = chrono::steady_clock::now() - start;
+  cout << total_dollars << " dollars, " << total_yen << " yen, " << titles_with_d << " D\n";
+
+  cout << "scan fixed:   " << fixed_time.count()/rounds << " ms\n";
+  cout << "scan compact: " << compact_time.count()/rounds << " ms\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+The Hobbit by J.R.R. Tolkien
+fixed:   108 bytes per book
+compact: 39 bytes per book
+
+Each compact book takes 24 bytes, and the other 15 are the characters of its long texts in the heap. The same
+long titles and names are stored again for every book; storing each different text only once is the subject
+of string interning.
+
+Notice that the compact union is anonymous, as in book2_t, so its members are accessed directly as b.dollars
+and b.yen, while the tag tells which one is valid. Reading the member that was not written last, such as
+b.yen when currency is dollars, gives a meaningless value.
+
+Also notice that the class text_ref does not keep a pointer to the heap, but an offset from its beginning. The
+heap is a string that grows as books are added, and each time it grows it may move its characters to another
+place in memory, which would leave any pointer to them invalid; an offset stays valid. Being 16 and 32 bits
+wide, the length and the offset limit a text to 65535 characters and the heap to 4 GB; the constructor of
+text_ref throws length_error, from the header <stdexcept>, instead of silently cutting them.*/
@@ -0,0 +1,206 @@
+/*Names of enumerators
+The enumerated types of the first example, such as colors_t, months_t, Colors or EyeColor, exist only for
+the compiler: once the program is compiled, red is just the number 4, and the program has no way of knowing
+that it was called "red". To print it, or to read it from a configuration file, the names have to be written
+in the program again, as strings.
+
+A class template with a specialization for each enumerated type can hold this information, so that other
+templates can use it without knowing which enum they are working with:
+
+template <class E> struct enum_info;
+
+template <> struct enum_info<colors_t> {
+  static constexpr int first = black;
+  static constexpr int count = 8;
+  static constexpr const char* names[count] = {"black", "blue", ...};
+};
+
+Converting a value to its name is then just reading names[value - first]. The opposite conversion, from a
+string to the value, is usually written as a chain of ifs that compares the string with every name, or with a
+std::map<string,colors_t>, which compares it with about log2(count) names.
+
+There is a faster way: a hash function turns the string into a number (the one below mixes all its
+characters, one after the other), and that number is used as the index of a small table that tells which
+name it can be. Since the names are known in advance, we can look for a hash function that gives a different
+index to each of them (a perfect hash): the hash below depends on a seed, and seeds are tried one after the
+other until the indexes of all the names are different. This search is done only once, the first time a
+string is parsed. Then each parse computes the hash, reads one element of the table and compares the string
+with a single name, to reject words that are not names at all. (If none of the first 10000 seeds works, which
+with this hash practically only happens when two names are equal, parse compares the string with every name
+instead.)*/
+
+// names of enumerators
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <map>
+#include <cstdlib>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+enum colors_t {black, blue, green, cyan, red, purple, yellow, white};
+enum months_t { january=1, february, march, april,
+                may, june, july, august,
+                september, october, november, december};
+enum class Colors {black, blue, green, cyan, red, purple, yellow, white};
+enum class EyeColor : char {blue, green, brown};
+
+template <class E> struct enum_info;
+
+template <> struct enum_info<colors_t> {
+  static constexpr int first = black;
+  static constexpr int count = 8;
+  static constexpr const char* names[count] = {"black", "blue", "green", "cyan", "red", "purple", "yellow", "white"};
+};
+
+template <> struct enum_info<months_t> {
+  static constexpr int first = january;
+  static constexpr int count = 12;
+  static constexpr const char* names[count] = {"january", "february", "march", "april", "may", "june",
+                                               "july", "august", "september", "october", "november", "december"};
+};
+
+template <> struct enum_info<Colors> {
+  static constexpr int first = int (Colors::black);
+  static constexpr int count = 8;
+  static constexpr const char* names[count] = {"black", "blue", "green", "cyan", "red", "purple", "yellow", "white"};
+};
+
+template <> struct enum_info<EyeColor> {
+  static constexpr int first = int (EyeColor::blue);
+  static constexpr int count = 3;
+  static constexpr const char* names[count] = {"blue", "green", "brown"};
+};
+
+constexpr const char* enum_info<colors_t>::names[];
+constexpr const char* enum_info<months_t>::names[];
+constexpr const char* enum_info<Colors>::names[];
+constexpr const char* enum_info<EyeColor>::names[];
+
+static_assert (enum_info<colors_t>::count == white - black + 1, "missing names in colors_t");
+static_assert (enum_info<months_t>::count == december - january + 1, "missing names in months_t");
+
+template <class E>
+const char* name_of (E value)
+{
+  return enum_info<E>::names[int (value) - enum_info<E>::first];
+}
+
+// mixes all the characters: hashing only some of them would give the same value to names that only differ
+// in the others, such as "abcd" and "axcd", whatever the seed
+uint32_t name_hash (const char* text, size_t length, uint32_t seed)
+{
+  uint32_t h = seed ^ 2166136261u;
+  for (size_t i=0; i<length; i++)
+    h = (h ^ (unsigned char) text[i]) * 16777619u;
+  return h ^ (h >> 15);
+}
+
+template <class E>
+class perfect_hash {
+    static const int size = 64;                 // a power of 2, at least twice the number of names
+    static const uint32_t max_seed = 10000;
+    uint32_t seed;                              // 0 if no seed was found: find compares with every name
+    unsigned char slot[size];                   // index of the name + 1, or 0 if empty
+    size_t lengths[enum_info<E>::count];
+  public:
+    perfect_hash ()
+    {
+      static_assert (enum_info<E>::count * 2 <= size, "too many names for the table");
+      for (int i=0; i<enum_info<E>::count; i++)
+        lengths[i] = strlen (enum_info<E>::names[i]);
+      for (seed=1; seed<=max_seed; seed++) {
+        memset (slot, 0, size);
+        bool collision = false;
+        for (int i=0; i<enum_info<E>::count && !collision; i++) {
+          unsigned char& s = slot[name_hash (enum_info<E>::names[i], lengths[i], seed) & (size-1)];
+          if (s) collision = true;
+          else s = (unsigned char) (i+1);
+        }
+        if (!collision) return;
+      }
+      seed = 0;
+    }
+    // returns true and sets value if text is the name of an enumerator
+    bool find (const char* text, size_t length, E& value) const
+    {
+      if (seed == 0) {
+        for (int i=0; i<enum_info<E>::count; i++)
+          if (lengths[i] == length && memcmp (enum_info<E>::names[i], text, length) == 0) {
+            value = E (i + enum_info<E>::first);
+            return true;
+          }
+        return false;
+      }
+      int s = slot[name_hash (text, length, seed) & (size-1)];
+      if (s == 0) return false;
+      if (lengths[s-1] != length || memcmp (enum_info<E>::names[s-1], text, length) != 0) return false;
+      value = E (s-1 + enum_info<E>::first);
+      return true;
+    }
+};
+
+template <class E>
+bool parse (const string& text, E& value)
+{
+  static const perfect_hash<E> table;
+  return table.find (text.data(), text.size(), value);
+}
+
+int main (int argc, char* argv[])
+{
+  months_t month;
+  Colors color;
+  EyeColor eyes;
+  if (parse (string ("september"), month)) cout << "september is month " << month << '\n';
+  if (parse (string ("red"), color)) cout << "red is " << int (color) << ", " << name_of (color) << '\n';
+  if (!parse (string ("violet"), color)) cout << "violet is not a color\n";
+  if (parse (string ("brown"), eyes)) cout << "brown eyes: " << name_of (eyes) << '\n';
+  cout << name_of (purple) << ' ' << name_of (march) << '\n';
+
+  // tokens read from a configuration file, a few of them are not colors
+  vector<string> tokens;
+  for (int i=0; i<4096; i++)
+    tokens.push_back (i%16 == 0 ? string ("violet") : string (enum_info<Colors>::names[i*5%8]));
+  map<string,Colors> by_name;
+  for (int i=0; i<enum_info<Colors>::count; i++)
+    by_name[enum_info<Colors>::names[i]] = Colors (i);
+
+  long total = 100000000;
+  if (argc > 1) total = atol (argv[1]);
+  long found = 0;
+  auto start = chrono::steady_clock::now();
+  for (long i=0; i<total; i++) {
+    map<string,Colors>::const_iterator it = by_name.find (tokens[i & 4095]);
+    if (it != by_name.end()) found += int (it->second);
+  }
+  chrono::duration<double,nano> with_map = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (long i=0; i<total; i++)
+    if (parse (tokens[i & 4095], color)) found -= int (color);
+  chrono::duration<double,nano> with_hash = chrono::steady_clock::now() - start;
+  if (found != 0) cout << "map and perfect hash give different results\n";
+
+  cout << "std::map:     " << with_map.count()/total << " ns per token\n";
+  cout << "perfect hash: " << with_hash.count()/total << " ns per token\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+september is month 9
+red is 4, red
+violet is not a color
+brown eyes: brown
+purple march
+
+By default the program parses 10^8 tokens; a different number can be given as its first argument.
+
+Notice how the names of the enumerators in enum_info are declared static constexpr inside the class, and then
+defined again outside of it, without their initializer. In C++11 and C++14, a static data member that is used
+as an object (here, the array is indexed at runtime) needs this definition in exactly one place of the program.
+
+The static_assert declarations check a condition at compile time, and stop the compilation with the given
+message when it is false. Here they make sure that no enumerator is added to colors_t or months_t without
+adding its name.*/
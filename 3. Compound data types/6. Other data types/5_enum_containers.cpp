@@ -0,0 +1,166 @@
+/*Containers indexed by enumerated types
+When some data has to be kept for each color of colors_t, or for each month of months_t, the first
+idea is often a std::map<colors_t,int>. But a map is made for keys that can take any value, and it finds
+each one by comparing it with several others, following pointers between nodes spread in memory.
+
+The values of an enumerated type, on the other hand, are a few consecutive integers known at compile time.
+So the data can be kept in a plain array, and the value of the enumerator (minus the value of the first one)
+used as the index: finding the element of a key is a subtraction and a single read from memory.
+
+The class template EnumMap below does this. It learns the number of enumerators from enum_info, the class
+template of the previous example that holds what we know about each enumerated type, so the size of its array
+is a constant expression:
+
+template <class E, class V>
+class EnumMap {
+    V values[enum_info<E>::count];
+  ...
+};
+
+In the same way, a set of enumerators only needs one bit per enumerator: the class template EnumSet keeps
+them in an array of 64-bit integers, and the union or intersection of two sets is one | or & per 64
+enumerators, which the compiler can also do with vector instructions when there are many of them.*/
+
+// containers indexed by enums
+#include <iostream>
+#include <map>
+#include <unordered_map>
+#include <vector>
+#include <chrono>
+#include <stdint.h>
+using namespace std;
+
+enum colors_t {black, blue, green, cyan, red, purple, yellow, white};
+enum months_t { january=1, february, march, april,
+                may, june, july, august,
+                september, october, november, december};
+
+template <class E> struct enum_info;
+
+template <> struct enum_info<colors_t> {
+  static constexpr int first = black;
+  static constexpr int count = white - black + 1;
+};
+
+template <> struct enum_info<months_t> {
+  static constexpr int first = january;
+  static constexpr int count = december - january + 1;
+};
+
+template <class E, class V>
+class EnumMap {
+    V values[enum_info<E>::count];
+  public:
+    EnumMap () : values () {}
+    V& operator[] (E key) {return values[int (key) - enum_info<E>::first];}
+    const V& operator[] (E key) const {return values[int (key) - enum_info<E>::first];}
+    static constexpr int size () {return enum_info<E>::count;}
+};
+
+template <class E>
+class EnumSet {
+    static const int words = (enum_info<E>::count + 63) / 64;
+    uint64_t bits[words];
+    static int index (E e) {return int (e) - enum_info<E>::first;}
+  public:
+    EnumSet () : bits () {}
+    void insert (E e) {bits[index (e)/64] |= uint64_t (1) << (index (e)%64);}
+    void erase (E e) {bits[index (e)/64] &= ~(uint64_t (1) << (index (e)%64));}
+    bool contains (E e) const {return (bits[index (e)/64] >> (index (e)%64)) & 1;}
+    int size () const
+    {
+      int count = 0;
+      for (int w=0; w<words; w++)
+        for (uint64_t b = bits[w]; b; b &= b-1)
+          count++;
+      return count;
+    }
+    EnumSet operator| (const EnumSet& other) const
+    {
+      EnumSet result;
+      for (int w=0; w<words; w++) result.bits[w] = bits[w] | other.bits[w];
+      return result;
+    }
+    EnumSet operator& (const EnumSet& other) const
+    {
+      EnumSet result;
+      for (int w=0; w<words; w++) result.bits[w] = bits[w] & other.bits[w];
+      return result;
+    }
+    EnumSet operator- (const EnumSet& other) const
+    {
+      EnumSet result;
+      for (int w=0; w<words; w++) result.bits[w] = bits[w] & ~other.bits[w];
+      return result;
+    }
+};
+
+// before C++14, std::hash is not defined for enumerated types
+struct enum_hash {
+  template <class E> size_t operator() (E e) const {return size_t (e);}
+};
+
+int main ()
+{
+  EnumMap<months_t,int> days;
+  int lengths[12] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+  for (int m=january; m<=december; m++)
+    days[months_t (m)] = lengths[m-1];
+  cout << "april has " << days[april] << " days\n";
+
+  EnumSet<months_t> summer, with_31_days;
+  summer.insert (june); summer.insert (july); summer.insert (august);
+  for (int m=january; m<=december; m++)
+    if (days[months_t (m)] == 31) with_31_days.insert (months_t (m));
+  EnumSet<months_t> both = summer & with_31_days;
+  cout << both.size() << " summer months have 31 days, june is "
+       << (both.contains (june) ? "" : "not ") << "one of them\n";
+
+  // count how many times each color appears in a long list
+  const int n = 1<<16, rounds = 500;
+  vector<colors_t> list (n);
+  for (int i=0; i<n; i++)
+    list[i] = colors_t ((i*2654435761u >> 7) % 8);
+
+  map<colors_t,long> by_map;
+  unordered_map<colors_t,long,enum_hash> by_hash;
+  EnumMap<colors_t,long> by_enum;
+
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      by_map[list[i]]++;
+  chrono::duration<double,nano> map_time = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      by_hash[list[i]]++;
+  chrono::duration<double,nano> hash_time = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      by_enum[list[i]]++;
+  chrono::duration<double,nano> enum_time = chrono::steady_clock::now() - start;
+
+  for (int c=black; c<=white; c++)
+    if (by_map[colors_t (c)] != by_enum[colors_t (c)] || by_hash[colors_t (c)] != by_enum[colors_t (c)])
+      cout << "different counts for color " << c << '\n';
+
+  double total = double (n) * rounds;
+  cout << "std::map:           " << map_time.count()/total << " ns per lookup\n";
+  cout << "std::unordered_map: " << hash_time.count()/total << " ns per lookup\n";
+  cout << "EnumMap:            " << enum_time.count()/total << " ns per lookup\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+april has 30 days
+2 summer months have 31 days, june is not one of them
+
+Notice that EnumMap and EnumSet do not need to be told how many enumerators there are: it is taken from
+enum_info<E>::count, and since enum_info has no generic definition, using them with an enumerated type that has
+no specialization of enum_info is an error at compile time.
+
+The expression b &= b-1, in the member function size of EnumSet, clears the lowest bit of b that is set, so the
+loop runs once for each enumerator in the set.*/
@@ -0,0 +1,211 @@
+/*Tracking the lifetime of objects
+The static member n of Dummy counts how many objects of the class have been constructed, and the previous
+example made it safe to use from many threads. To find leaks, or to know how much memory a class needs, we
+usually want to know more: how many objects are alive right now (constructed but not yet destroyed), the
+highest number that has been alive at the same time (the peak), and which threads construct them.
+
+The class template tracked below gives this to any class that derives from it, without writing anything in the
+class itself. Its constructors and its destructor update the counters of lifetime_registry<T>, where T is the
+class that derives from tracked:
+
+class Dummy : public tracked<Dummy> {
+  ...
+};
+
+A class that passes itself as template argument to its base class is a common pattern (called the curiously
+recurring template pattern), and here it gives each tracked class its own registry, with its own counters.
+
+To keep the constructor cheap, the counters are not shared between threads: each thread has its own record,
+allocated the first time it constructs or destroys an object of the class, and only that thread writes to it.
+The records are atomic, so that other threads can read them, but the owner updates them with a relaxed load
+and a relaxed store, not with an atomic increment: since no other thread writes to them, nothing can happen
+in between, and these are as cheap as ordinary reads and writes. Only the first use from each thread locks
+a mutex, to add its record to the list of the registry.
+
+Each object keeps a pointer to the record of the thread that constructed it, and its destructor counts it in
+that record: as destroyed, if it is the same thread, or else as destroyed_elsewhere, with an atomic increment,
+since several threads can destroy objects of the same owner at once. So the live count of a record is the
+number of objects that its thread constructed and are still alive, wherever they are destroyed, and its peak
+is the highest value this count had when the thread constructed an object.
+
+The function snapshot adds up the records of all the threads. An exact overall peak would need a live count
+shared by all the threads, updated by every constructor and destructor, which is what the records avoid. So the
+snapshot only gives a lower bound, observed_peak: the largest of the peaks of the threads and of the live counts
+seen by the snapshots. Each of them counts objects that were alive at the same time, but it is lower than the
+real peak when several threads had live objects at once.*/
+
+// lifetime registry
+#include <iostream>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+struct thread_record {
+  int thread_number;
+  atomic<long> constructed, destroyed, peak;
+  atomic<long> destroyed_elsewhere;      // objects constructed by this thread and destroyed by another one
+  thread_record (int number) : thread_number (number), constructed (0), destroyed (0), peak (0),
+                               destroyed_elsewhere (0) {}
+};
+
+struct lifetime_snapshot {
+  long live, observed_peak, total;           // observed_peak is a lower bound of the real peak
+  struct per_thread { int thread_number; long constructed, destroyed, peak; };
+  vector<per_thread> threads;
+};
+
+template <class T>
+class lifetime_registry {
+    static mutex lock;
+    static vector<thread_record*> records;
+    static long observed_peak;
+    static thread_record* attach ()
+    {
+      lock_guard<mutex> guard (lock);
+      // records are never deleted, so that the counts of finished threads stay in the snapshots
+      records.push_back (new thread_record (int (records.size())));
+      return records.back();
+    }
+    static thread_record& mine ()
+    {
+      thread_local thread_record* record = attach();
+      return *record;
+    }
+    static void bump (atomic<long>& counter)
+    {
+      counter.store (counter.load (memory_order_relaxed) + 1, memory_order_relaxed);
+    }
+  public:
+    // returns the record of the thread, which the object keeps to know where it was constructed
+    static thread_record* constructed ()
+    {
+      thread_record& r = mine();
+      bump (r.constructed);
+      long live = r.constructed.load (memory_order_relaxed) - r.destroyed.load (memory_order_relaxed)
+                  - r.destroyed_elsewhere.load (memory_order_relaxed);
+      if (live > r.peak.load (memory_order_relaxed)) r.peak.store (live, memory_order_relaxed);
+      return &r;
+    }
+    static void destroyed (thread_record* owner)
+    {
+      thread_record& r = mine();
+      if (owner == &r) bump (r.destroyed);
+      else owner->destroyed_elsewhere.fetch_add (1, memory_order_relaxed);    // other threads may do the same
+    }
+    static lifetime_snapshot snapshot ()
+    {
+      lock_guard<mutex> guard (lock);
+      lifetime_snapshot s;
+      s.live = s.total = 0;
+      for (size_t i=0; i<records.size(); i++) {
+        lifetime_snapshot::per_thread t = {records[i]->thread_number, records[i]->constructed.load (memory_order_relaxed),
+                                           records[i]->destroyed.load (memory_order_relaxed) +
+                                           records[i]->destroyed_elsewhere.load (memory_order_relaxed),
+                                           records[i]->peak.load (memory_order_relaxed)};
+        s.threads.push_back (t);
+        s.live += t.constructed - t.destroyed;
+        s.total += t.constructed;
+        if (t.peak > observed_peak) observed_peak = t.peak;
+      }
+      if (s.live > observed_peak) observed_peak = s.live;
+      s.observed_peak = observed_peak;
+      return s;
+    }
+};
+
+template <class T> mutex lifetime_registry<T>::lock;
+template <class T> vector<thread_record*> lifetime_registry<T>::records;
+template <class T> long lifetime_registry<T>::observed_peak = 0;
+
+template <class T>
+class tracked {
+    thread_record* owner;
+  protected:
+    tracked () : owner (lifetime_registry<T>::constructed()) {}
+    tracked (const tracked&) : owner (lifetime_registry<T>::constructed()) {}
+    tracked& operator= (const tracked&) {return *this;}      // keeps its own owner
+    ~tracked () {lifetime_registry<T>::destroyed (owner);}
+};
+
+class Dummy : public tracked<Dummy> {
+};
+
+// two classes of the same size, with and without tracking, for the microbenchmark
+class Plain {
+  public:
+    int value;
+    Plain (int v) : value (v) {}
+};
+
+class Tracked : public tracked<Tracked> {
+  public:
+    int value;
+    Tracked (int v) : value (v) {}
+};
+
+template <class C>
+double nanoseconds_per_object (long count)
+{
+  volatile int sink = 0;
+  auto start = chrono::steady_clock::now();
+  for (long i=0; i<count; i++) {
+    C object ((int) i);
+    sink = object.value;
+  }
+  chrono::duration<double,nano> elapsed = chrono::steady_clock::now() - start;
+  if (sink != int (count-1)) cout << "wrong value\n";
+  return elapsed.count() / count;
+}
+
+void print (const lifetime_snapshot& s)
+{
+  cout << "live " << s.live << ", observed peak " << s.observed_peak << ", total " << s.total << " (";
+  for (size_t i=0; i<s.threads.size(); i++)
+    cout << (i ? ", " : "") << "thread " << s.threads[i].thread_number << ": " << s.threads[i].constructed;
+  cout << ")\n";
+}
+
+int main () {
+  Dummy a;
+  Dummy * c = new Dummy;
+  {
+    Dummy b[5];
+    print (lifetime_registry<Dummy>::snapshot());
+  }
+  delete c;
+  thread worker ([] {
+    vector<Dummy> many (100);
+  });
+  worker.join();
+  print (lifetime_registry<Dummy>::snapshot());
+
+  const long count = 100000000;
+  double plain = nanoseconds_per_object<Plain> (count);
+  double with_tracking = nanoseconds_per_object<Tracked> (count);
+  cout << "plain " << plain << " ns, tracked " << with_tracking << " ns per object: "
+       << with_tracking - plain << " ns of overhead"
+       << (with_tracking - plain < 5 ? ", under 5 ns\n" : ", more than 5 ns\n");
+  print (lifetime_registry<Tracked>::snapshot());
+  return 0;
+}
+/*Output (the timings depend on the machine; compile with -pthread):
+live 7, observed peak 7, total 7 (thread 0: 7)
+live 1, observed peak 100, total 107 (thread 0: 7, thread 1: 100)
+
+The second observed peak is 100, although a was also alive while the worker thread had its 100 objects, so
+the real peak was 101: neither that thread nor any snapshot saw the 101 objects at the same time.
+
+A thread that only constructs objects and hands them to another one, which destroys each of them before the
+next is made, gets a peak of 1, since each destruction is counted in its record as destroyed_elsewhere.
+
+Notice that the constructors and the destructor of tracked are protected: only derived classes can use them,
+so nobody can create a tracked object by itself. The copy constructor has to be written too: the one that the
+compiler would define does not call lifetime_registry<T>::constructed, and copies would not be counted, but
+their destruction would. And so does the assignment: the one of the compiler would copy owner, and the object
+would then be counted as destroyed in the record of another thread.
+
+Also notice that the static data members of lifetime_registry are defined outside the class as templates, once
+for all the classes T. The compiler creates a separate set of them for each class that uses the registry.*/
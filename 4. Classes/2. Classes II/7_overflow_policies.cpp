@@ -0,0 +1,144 @@
+/*Overflow policies as template parameters
+The CVector class of the overloading operators example adds its coordinates with the built-in
+operator + for int:
+
+temp.x = x + param.x;
+temp.y = y + param.y;
+
+When the result does not fit in an int, signed overflow happens. The standard says this is
+undefined behavior, and in practice most machines just wrap around, so adding 1 to 2147483647
+gives -2147483648. Sometimes this is fine, but often we would prefer the result to stay at the
+largest value (saturate), or at least to know that something went wrong (checked).
+
+Instead of writing three different vector classes, the way of adding two ints can be passed
+as a template parameter. Such a class, that only groups a few static member functions describing
+how some operation has to be done, is usually called a policy:
+
+struct saturate_policy {
+  static int add (int a, int b, unsigned& overflow);
+};
+
+template <class Policy>
+class CVector { ... };
+
+CVector<saturate_policy> foo (2147483647, 1);
+
+Every policy below computes the wrapped sum with unsigned arithmetic (where wrap around is well
+defined) and detects the overflow without any if: the sum overflowed only when both operands have
+the same sign and the result has a different one, which is the sign bit of ((a^s)&(b^s)).
+Because there are no branches, the compiler is able to turn the loop in add_arrays into
+vector instructions that add, compare and blend several ints at the same time. GCC 12 does it
+with -O3; at -O2 it only vectorizes loops that need no extra checks, and this one needs to check
+at runtime that out does not overlap a or b, so it stays a loop of one int at a time.*/
+
+// overflow policies
+#include <iostream>
+#include <climits>
+#include <chrono>
+#include <vector>
+using namespace std;
+
+struct wrap_policy {
+  static int add (int a, int b, unsigned&)
+  {
+    return int(unsigned(a) + unsigned(b));
+  }
+};
+
+struct saturate_policy {
+  static int add (int a, int b, unsigned&)
+  {
+    int s = int(unsigned(a) + unsigned(b));
+    int limit = (a>>31) ^ INT_MAX;          // INT_MIN if a<0, INT_MAX otherwise
+    return ((a^s)&(b^s)) < 0 ? limit : s;
+  }
+};
+
+struct checked_policy {
+  static int add (int a, int b, unsigned& overflow)
+  {
+    int s = int(unsigned(a) + unsigned(b));
+    overflow |= unsigned((a^s)&(b^s)) >> 31;
+    return s;
+  }
+};
+
+template <class Policy>
+class CVector {
+  public:
+    int x,y;
+    bool overflow;
+    CVector () : x(0), y(0), overflow(false) {}
+    CVector (int a, int b) : x(a), y(b), overflow(false) {}
+    CVector operator + (const CVector&) const;
+};
+
+template <class Policy>
+CVector<Policy> CVector<Policy>::operator+ (const CVector& param) const {
+  unsigned flag = 0;
+  CVector temp;
+  temp.x = Policy::add (x, param.x, flag);
+  temp.y = Policy::add (y, param.y, flag);
+  temp.overflow = overflow || param.overflow || flag!=0;
+  return temp;
+}
+
+// adds n ints of a and b into out, returns true if any addition overflowed
+template <class Policy>
+bool add_arrays (const int* a, const int* b, int* out, int n)
+{
+  unsigned flag = 0;
+  for (int i=0; i<n; i++)
+    out[i] = Policy::add (a[i], b[i], flag);
+  return flag!=0;
+}
+
+template <class Policy>
+double time_policy (const vector<int>& a, const vector<int>& b, vector<int>& out, int rounds)
+{
+  bool overflow = false;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    overflow |= add_arrays<Policy> (a.data(), b.data(), out.data(), int(a.size()));
+  chrono::duration<double,nano> elapsed = chrono::steady_clock::now() - start;
+  if (overflow) out[0] ^= 1;                // keep the flag alive
+  return elapsed.count() / (double(rounds) * a.size());
+}
+
+int main () {
+  CVector<wrap_policy> w1 (INT_MAX,1), w2 (1,2);
+  CVector<saturate_policy> s1 (INT_MAX,1), s2 (1,2);
+  CVector<checked_policy> c1 (INT_MAX,1), c2 (1,2);
+  CVector<wrap_policy> wr = w1 + w2;
+  CVector<saturate_policy> sr = s1 + s2;
+  CVector<checked_policy> cr = c1 + c2;
+  cout << "wrap:     " << wr.x << ',' << wr.y << '\n';
+  cout << "saturate: " << sr.x << ',' << sr.y << '\n';
+  cout << "checked:  " << cr.x << ',' << cr.y << (cr.overflow ? " (overflow)" : "") << '\n';
+
+  const int n = 1<<16, rounds = 2000;
+  vector<int> a (n), b (n), out (n);
+  for (int i=0; i<n; i++) {
+    a[i] = int(unsigned(i)*40503u);
+    b[i] = INT_MAX - i*7919;
+  }
+  cout << "ns per addition\n";
+  cout << "wrap:     " << time_policy<wrap_policy> (a, b, out, rounds) << '\n';
+  cout << "saturate: " << time_policy<saturate_policy> (a, b, out, rounds) << '\n';
+  cout << "checked:  " << time_policy<checked_policy> (a, b, out, rounds) << '\n';
+  return 0;
+}
+/*Output (the timings depend on the machine and on the optimization flags, use -O3):
+wrap:     -2147483648,3
+saturate: 2147483647,3
+checked:  -2147483648,3 (overflow)
+
+Notice that the policy is never stored in the object: its member functions are static, so calling
+Policy::add is resolved at compile time and inlined exactly like the plain + of the original CVector,
+and the loop of each version of add_arrays is vectorized. The differences between them are only the
+few extra instructions of each policy: checked costs little more than wrap, since it only adds an or
+to the flag, while saturate takes about twice as long, since it also computes the limit and blends it
+with the sum.
+
+The overflow member only has meaning with checked_policy; it is sticky, so in an expression such as
+a + b + c it reports whether any of the additions overflowed.*/
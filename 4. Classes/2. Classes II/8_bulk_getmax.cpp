@@ -0,0 +1,155 @@
+/*Function templates working on arrays of class templates
+The mypair class template of the class templates example returns the greatest of its two
+values with the member function getmax. When there are millions of pairs, calling getmax
+once for each object works, but it hides from the compiler that the same operation is repeated
+over a whole array.
+
+A function template that receives the complete array can be written instead:
+
+template <class T>
+void getmax_bulk (const mypair<T>* pairs, T* result, int n);
+
+Since the members a and b of mypair are private, the function is declared as a friend of
+the class template (friendship is explained in a later chapter). A second version takes the
+values in two separate arrays, a[] and b[], which is the best layout when the values do not
+need to be grouped in objects:
+
+template <class T>
+void getmax_bulk (const T* a, const T* b, T* result, int n);
+
+In both cases the body of the loop is the same expression used by getmax, a>b? a : b, with no
+local variables and no branches. This loop is instantiated separately for each type, so for
+int the compiler emits the instructions that compute the maximum of several ints at once,
+for float and double the ones that do it for floating point values, and for signed char the
+ones that work on 16 or 32 bytes at the same time.*/
+
+// bulk getmax
+#include <iostream>
+#include <chrono>
+#include <vector>
+using namespace std;
+
+template <class T> class mypair;
+
+template <class T>
+void getmax_bulk (const mypair<T>* pairs, T* result, int n);
+
+template <class T>
+class mypair {
+    T a, b;
+  public:
+    mypair () {}
+    mypair (T first, T second)
+      {a=first; b=second;}
+    T getmax ();
+    friend void getmax_bulk<T> (const mypair<T>* pairs, T* result, int n);
+};
+
+template <class T>
+T mypair<T>::getmax ()
+{
+  T retval;
+  retval = a>b? a : b;
+  return retval;
+}
+
+template <class T>
+void getmax_bulk (const mypair<T>* pairs, T* result, int n)
+{
+  for (int i=0; i<n; i++)
+    result[i] = pairs[i].a > pairs[i].b ? pairs[i].a : pairs[i].b;
+}
+
+template <class T>
+void getmax_bulk (const T* a, const T* b, T* result, int n)
+{
+  for (int i=0; i<n; i++)
+    result[i] = a[i] > b[i] ? a[i] : b[i];
+}
+
+// explicit instantiations for the types we use
+template void getmax_bulk<int> (const mypair<int>*, int*, int);
+template void getmax_bulk<float> (const mypair<float>*, float*, int);
+template void getmax_bulk<double> (const mypair<double>*, double*, int);
+template void getmax_bulk<signed char> (const mypair<signed char>*, signed char*, int);
+template void getmax_bulk<int> (const int*, const int*, int*, int);
+template void getmax_bulk<float> (const float*, const float*, float*, int);
+template void getmax_bulk<double> (const double*, const double*, double*, int);
+template void getmax_bulk<signed char> (const signed char*, const signed char*, signed char*, int);
+
+template <class T>
+void benchmark (const char* name, int n, int rounds)
+{
+  vector<mypair<T> > pairs;
+  vector<T> a (n), b (n), result (n);
+  for (int i=0; i<n; i++) {
+    a[i] = T((i*37)%101);
+    b[i] = T((i*53)%97);
+    pairs.push_back (mypair<T> (a[i], b[i]));
+  }
+
+  // getmax is called through a pointer read from a volatile variable, so that the compiler cannot inline it
+  // into the loop and vectorize it, as it would do if it saw the whole loop: this is the cost of one call per
+  // object, as when getmax is defined in another file
+  T (mypair<T>::* volatile getmax) () = &mypair<T>::getmax;
+  // each round reads one element of the result, so that the compiler cannot skip the rounds that only repeat
+  // the first one
+  long check = 0, expected = 0;
+  chrono::duration<double,nano> one, bulk, split;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++) {
+    for (int i=0; i<n; i++)
+      result[i] = (pairs[i].*getmax)();
+    expected += long (result[r % n]);
+  }
+  one = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++) {
+    getmax_bulk (pairs.data(), result.data(), n);
+    check += long (result[r % n]);
+  }
+  bulk = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++) {
+    getmax_bulk (a.data(), b.data(), result.data(), n);
+    check += long (result[r % n]);
+  }
+  split = chrono::steady_clock::now() - start;
+
+  double total = double(n) * rounds;
+  cout << name << ": getmax " << one.count()/total
+       << " ns, bulk pairs " << bulk.count()/total
+       << " ns, bulk split " << split.count()/total << " ns"
+       << (check == 2*expected ? "\n" : " (different results!)\n");
+}
+
+int main () {
+  mypair <int> myobjects[3] = { mypair<int> (100, 75), mypair<int> (3, 8), mypair<int> (-1, -2) };
+  int maxima[3];
+  getmax_bulk (myobjects, maxima, 3);
+  cout << maxima[0] << ' ' << maxima[1] << ' ' << maxima[2] << '\n';
+
+  benchmark<int> ("int", 1<<14, 2000);
+  benchmark<float> ("float", 1<<14, 2000);
+  benchmark<double> ("double", 1<<14, 2000);
+  benchmark<signed char> ("int8", 1<<14, 2000);
+  return 0;
+}
+/*Output (the timings depend on the machine; compile with -O3, since GCC 12 does not vectorize these loops at
+-O2, where the bulk versions only save the calls):
+100 8 -1
+
+Notice the syntax used to declare a specialization of the function template as a friend:
+
+friend void getmax_bulk<T> (const mypair<T>* pairs, T* result, int n);
+
+The <T> after the name means that only the instantiation of getmax_bulk for the same T is a friend
+of mypair<T>: getmax_bulk<int> can access the members of mypair<int>, but not those of mypair<double>.
+For this to work, the function template has to be declared before the class template, which itself
+also needs to be declared before that declaration.
+
+The lines starting with template void are explicit instantiations: they ask the compiler to generate
+the function for that type even if it is not called anywhere, which is useful to check that all the
+types we care about compile, or to build them once in a library.*/
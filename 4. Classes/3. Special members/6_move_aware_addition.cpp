@@ -0,0 +1,192 @@
+/*Additions that reuse their temporaries
+The operator+ of Example6, in the move example, returns Example6(content()+rhs.content()): content()+rhs.content()
+allocates a new string with the result, and the constructor of Example6 allocates another string with new and
+copies the result into it. In an expression with several additions:
+
+foo = foo + bar + baz + qux;
+
+this happens for each +, although the left operand of every + except the first one is an unnamed temporary,
+the result of the previous addition, that is going to be destroyed right after.
+
+The member functions of a class can be overloaded depending on whether the object they are called on is a
+temporary or not, with a reference qualifier after their parameter list, in the same way as const:
+
+Example6 operator+ (const Example6& rhs) const &;   // called on named objects (lvalues)
+Example6 operator+ (const Example6& rhs) &&;        // called on temporaries (rvalues)
+
+The version for lvalues cannot modify its object, so it allocates the result, but it reserves the length of
+both operands first, so the string is allocated once. The version for temporaries appends rhs directly to the
+string of the temporary, and moves it into the returned object, which only copies the pointer. The string grows
+like any other string, reserving twice its size when it is full, so the additions after the first one almost
+never allocate.
+
+The same code can also be written as an accumulator: operator+= appends to the string of the object on its left,
+and is the natural choice inside a loop.
+
+To show how many allocations each expression makes, the program below replaces the global operator new, which
+is called by new and by every standard container, with a version that counts its calls.*/
+
+// addition with rvalue-qualified members
+#include <iostream>
+#include <string>
+#include <vector>
+#include <cstdlib>
+#include <new>
+#include <chrono>
+using namespace std;
+
+long allocations = 0;
+
+void* operator new (size_t size)
+{
+  allocations++;
+  void* p = malloc (size);
+  if (p == nullptr) throw bad_alloc();
+  return p;
+}
+
+void operator delete (void* p) noexcept
+{
+  free (p);
+}
+
+// since C++14, delete can call this form, which also gets the size
+void operator delete (void* p, size_t) noexcept
+{
+  free (p);
+}
+
+// the class of the move example
+class OldExample6 {
+    string* ptr;
+  public:
+    OldExample6 (const string& str) : ptr(new string(str)) {}
+    ~OldExample6 () {delete ptr;}
+    OldExample6 (OldExample6&& x) : ptr(x.ptr) {x.ptr=nullptr;}
+    OldExample6& operator= (OldExample6&& x) {
+      delete ptr;
+      ptr = x.ptr;
+      x.ptr=nullptr;
+      return *this;
+    }
+    const string& content() const {return *ptr;}
+    OldExample6 operator+(const OldExample6& rhs) {
+      return OldExample6(content()+rhs.content());
+    }
+};
+
+class Example6 {
+    string* ptr;
+  public:
+    Example6 (const string& str) : ptr(new string(str)) {}
+    ~Example6 () {delete ptr;}
+    // move constructor
+    Example6 (Example6&& x) : ptr(x.ptr) {x.ptr=nullptr;}
+    // move assignment
+    Example6& operator= (Example6&& x) {
+      delete ptr;
+      ptr = x.ptr;
+      x.ptr=nullptr;
+      return *this;
+    }
+    // access content:
+    const string& content() const {return *ptr;}
+    // addition on a named object: allocates the result once
+    Example6 operator+ (const Example6& rhs) const & {
+      string* result = new string;
+      result->reserve (ptr->size() + rhs.ptr->size());
+      *result += *ptr;
+      *result += *rhs.ptr;
+      return Example6 (result);
+    }
+    // addition on a temporary: appends to its string
+    Example6 operator+ (const Example6& rhs) && {
+      *ptr += *rhs.ptr;
+      return Example6 (std::move(*this));
+    }
+    // accumulation
+    Example6& operator+= (const Example6& rhs) {
+      *ptr += *rhs.ptr;
+      return *this;
+    }
+  private:
+    explicit Example6 (string* p) : ptr(p) {}
+};
+
+int main (int argc, char* argv[]) {
+  OldExample6 old_foo ("Examples of this sentence are repeated ");
+  OldExample6 old_bar ("once, "), old_baz ("twice, "), old_qux ("and three times.");
+  Example6 foo ("Examples of this sentence are repeated ");
+  Example6 bar ("once, "), baz ("twice, "), qux ("and three times.");
+
+  long before = allocations;
+  old_foo = old_foo + old_bar + old_baz + old_qux;
+  long old_count = allocations - before;
+  before = allocations;
+  foo = foo + bar + baz + qux;
+  long new_count = allocations - before;
+
+  cout << "foo's content: " << foo.content() << '\n';
+  cout << "allocations: " << old_count << " before, " << new_count << " now\n";
+
+  // chains of additions, such as sum = sum + piece repeated n times
+  long terms = 1000000;
+  if (argc > 1) terms = atol (argv[1]);
+  long old_terms = terms < 20000 ? terms : 20000;
+  vector<OldExample6> old_pieces;
+  vector<Example6> pieces;
+  for (int i=0; i<16; i++) {
+    old_pieces.push_back (OldExample6 (string (1 + i%5, char ('a'+i))));
+    pieces.push_back (Example6 (string (1 + i%5, char ('a'+i))));
+  }
+
+  before = allocations;
+  auto start = chrono::steady_clock::now();
+  OldExample6 old_sum ("");
+  for (long i=0; i<old_terms; i++)
+    old_sum = old_sum + old_pieces[i%16];
+  chrono::duration<double,nano> old_time = chrono::steady_clock::now() - start;
+  old_count = allocations - before;
+
+  before = allocations;
+  start = chrono::steady_clock::now();
+  Example6 sum ("");
+  for (long i=0; i<terms; i++)
+    sum = std::move(sum) + pieces[i%16];
+  chrono::duration<double,nano> rvalue_time = chrono::steady_clock::now() - start;
+  new_count = allocations - before;
+
+  before = allocations;
+  start = chrono::steady_clock::now();
+  Example6 total ("");
+  for (long i=0; i<terms; i++)
+    total += pieces[i%16];
+  chrono::duration<double,nano> accumulate_time = chrono::steady_clock::now() - start;
+  long accumulate_count = allocations - before;
+  if (total.content() != sum.content()) cout << "different results\n";
+
+  cout << "OldExample6, " << old_terms << " terms: " << double (old_count)/old_terms << " allocations and "
+       << old_time.count()/old_terms << " ns per term\n";
+  cout << "operator+ &&, " << terms << " terms: " << double (new_count)/terms << " allocations and "
+       << rvalue_time.count()/terms << " ns per term\n";
+  cout << "operator+=,   " << terms << " terms: " << double (accumulate_count)/terms << " allocations and "
+       << accumulate_time.count()/terms << " ns per term\n";
+  return 0;
+}
+/*Output (the timings depend on the machine):
+foo's content: Examples of this sentence are repeated once, twice, and three times.
+allocations: 12 before, 3 now
+
+The old class makes four allocations for each +: content()+rhs.content() copies the left string and grows it
+to append the right one, and the constructor allocates a new string and its characters. The new class makes two
+for the first +, the string and its characters, and the third one comes from the string growing while baz and
+qux are appended to the temporary.
+
+By default the chains have 10^6 terms, or the number given as the first argument, but the chain of OldExample6
+is limited to 20000 terms: each of its additions copies the whole sum, so its time grows with the square of the
+number of terms, while the other two only grow linearly.
+
+Notice the call std::move(*this) in the addition for temporaries. Inside a member function, *this is always an
+lvalue, even when the function is called on a temporary, so it has to be converted to an rvalue for the move
+constructor to be chosen. The same happens with std::move(sum) in the loop, which lets the compiler choose the
+addition for temporaries on a named object whose value is not going to be used anymore.*/
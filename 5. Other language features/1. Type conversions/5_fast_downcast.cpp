@@ -0,0 +1,248 @@
+/*Fast checked downcasts
+dynamic_cast<Derived*>(pba) checks at runtime whether pba points to an object of class Derived (or of a class
+derived from it). To answer, it has to find the type of the object in its RTTI, and then search the classes that
+this type derives from, one by one, until it finds Derived or runs out of bases. The deeper the hierarchy, the
+longer the search, and in a loop over many objects this can take a large part of the time.
+
+When all the classes of a hierarchy are known when the program is written (a closed hierarchy), the question
+can be answered with a single comparison. Number the classes in the order in which a depth-first walk of the
+hierarchy visits them, starting from the base: each class comes right before all the classes derived from it,
+so the classes derived from a class (including itself) have consecutive numbers, from the number of the class
+(first) to the number of its last descendant (last). For Polygon, Rectangle, Square and Triangle:
+
+Polygon    0  (first 0, last 3)
+Rectangle  1  (first 1, last 2)
+Square     2  (first 2, last 2)
+Triangle   3  (first 3, last 3)
+
+Each object keeps the number of its own class, type_id, in a member of the base class fast_castable, which each
+constructor sets by passing its number to the constructor of its base. Then an object is of class T, or of a
+class derived from T, if and only if T::first <= type_id <= T::last. With unsigned integers, this is a single
+comparison: values of type_id below first become very large numbers when first is subtracted from them.
+
+unsigned (type_id - T::first) <= unsigned (T::last - T::first)
+
+The function template fast_cast below does this check, and then converts the pointer with static_cast, which
+costs nothing at runtime. It only works for classes that derive from their base without virtual inheritance,
+as static_cast cannot convert a pointer to a virtual base into a pointer to its derived class.*/
+
+// fast downcasts
+#include <iostream>
+#include <vector>
+#include <chrono>
+using namespace std;
+
+class fast_castable {
+  protected:
+    fast_castable (int kind) : type_id (kind) {}
+  public:
+    const int type_id;
+    virtual ~fast_castable () {}
+};
+
+template <class T, class B>
+T* fast_cast (B* p)
+{
+  if (p && unsigned (p->type_id - T::first) <= unsigned (T::last - T::first))
+    return static_cast<T*> (p);
+  return nullptr;
+}
+
+class Base : public fast_castable {
+    virtual void dummy() {}
+  protected:
+    Base (int kind) : fast_castable (kind) {}
+  public:
+    static const int first = 0, last = 1;
+    Base () : fast_castable (first) {}
+};
+
+class Derived: public Base {
+    int a;
+  public:
+    static const int first = 1, last = 1;
+    Derived () : Base (first) {}
+};
+
+class Polygon : public fast_castable {
+  protected:
+    int width, height;
+    Polygon (int kind) : fast_castable (kind) {}
+  public:
+    static const int first = 0, last = 3;
+    Polygon () : fast_castable (first) {}
+    void set_values (int a, int b)
+      { width=a; height=b; }
+    virtual int area ()
+      { return 0; }
+};
+
+class Rectangle: public Polygon {
+  protected:
+    Rectangle (int kind) : Polygon (kind) {}
+  public:
+    static const int first = 1, last = 2;
+    Rectangle () : Polygon (first) {}
+    int area ()
+      { return width * height; }
+};
+
+class Square: public Rectangle {
+  public:
+    static const int first = 2, last = 2;
+    Square () : Rectangle (first) {}
+};
+
+class Triangle: public Polygon {
+  public:
+    static const int first = 3, last = 3;
+    Triangle () : Polygon (first) {}
+    int area ()
+      { return width * height / 2; }
+};
+
+static_assert (Rectangle::first > Polygon::first && Rectangle::last <= Polygon::last, "Rectangle outside Polygon");
+static_assert (Square::first > Rectangle::first && Square::last <= Rectangle::last, "Square outside Rectangle");
+static_assert (Triangle::first > Rectangle::last && Triangle::last <= Polygon::last, "Triangle outside Polygon");
+
+// a deep hierarchy: Deep<N> derives from Deep<N-1>
+const int depth = 16;
+
+template <int N>
+class Deep : public Deep<N-1> {
+  protected:
+    Deep (int kind) : Deep<N-1> (kind) {}
+  public:
+    static const int first = N, last = depth-1;
+    Deep () : Deep<N-1> (first) {}
+};
+
+template <>
+class Deep<0> : public fast_castable {
+  protected:
+    Deep (int kind) : fast_castable (kind) {}
+  public:
+    static const int first = 0, last = depth-1;
+    Deep () : fast_castable (first) {}
+};
+
+template <int N>
+Deep<0>* make_deep (int level)
+{
+  return level == N ? new Deep<N> : make_deep<N-1> (level);
+}
+
+template <>
+Deep<0>* make_deep<0> (int)
+{
+  return new Deep<0>;
+}
+
+// a wide hierarchy: all the Leaf<N> derive from Shape
+const int width = 32;
+
+class Shape : public fast_castable {
+  protected:
+    Shape (int kind) : fast_castable (kind) {}
+  public:
+    static const int first = 0, last = width;
+    Shape () : fast_castable (first) {}
+};
+
+template <int N>
+class Leaf : public Shape {
+  public:
+    static const int first = N, last = N;
+    Leaf () : Shape (N) {}
+};
+
+template <int N>
+Shape* make_leaf (int n)
+{
+  return n == N ? new Leaf<N> : make_leaf<N-1> (n);
+}
+
+template <>
+Shape* make_leaf<0> (int)
+{
+  return new Shape;
+}
+
+// times casting all the objects to T, first with dynamic_cast and then with fast_cast
+template <class T, class B>
+void benchmark (const char* name, const vector<B*>& objects, int rounds)
+{
+  long found = 0;
+  for (size_t i=0; i<objects.size(); i++)
+    if (dynamic_cast<T*> (objects[i]) != fast_cast<T> (objects[i])) cout << "different casts\n";
+
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<objects.size(); i++)
+      if (dynamic_cast<T*> (objects[i])) found++;
+  chrono::duration<double,nano> dynamic_time = chrono::steady_clock::now() - start;
+
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (size_t i=0; i<objects.size(); i++)
+      if (fast_cast<T> (objects[i])) found--;
+  chrono::duration<double,nano> fast_time = chrono::steady_clock::now() - start;
+  if (found != 0) cout << "different results\n";
+
+  double total = double (objects.size()) * rounds;
+  cout << name << "dynamic_cast " << dynamic_time.count() / total << " ns, fast_cast "
+       << fast_time.count() / total << " ns per cast\n";
+}
+
+int main () {
+  Base * pba = new Derived;
+  Base * pbb = new Base;
+  Derived * pd;
+
+  pd = fast_cast<Derived>(pba);
+  if (pd==0) cout << "Null pointer on first type-cast.\n";
+
+  pd = fast_cast<Derived>(pbb);
+  if (pd==0) cout << "Null pointer on second type-cast.\n";
+
+  Polygon * shapes[] = {new Rectangle, new Square, new Triangle, new Polygon};
+  for (int i=0; i<4; i++) {
+    shapes[i]->set_values (4,5);
+    Rectangle * r = fast_cast<Rectangle>(shapes[i]);
+    if (r) cout << "rectangle of area " << r->area() << '\n';
+    else cout << "not a rectangle, area " << shapes[i]->area() << '\n';
+  }
+
+  const int n = 1024, rounds = 10000;
+  vector<Deep<0>*> deep;
+  vector<Shape*> wide;
+  for (int i=0; i<n; i++) {
+    deep.push_back (make_deep<depth-1> (int ((i * 2654435761u) >> 8) % depth));
+    wide.push_back (make_leaf<width> (int ((i * 2654435761u) >> 8) % (width+1)));
+  }
+  benchmark<Deep<1> > ("deep, to level 1:  ", deep, rounds);
+  benchmark<Deep<12> > ("deep, to level 12: ", deep, rounds);
+  benchmark<Leaf<7> > ("wide, to a leaf:   ", wide, rounds);
+  return 0;
+}
+/*Output (the timings depend on the machine):
+Null pointer on second type-cast.
+rectangle of area 20
+rectangle of area 20
+not a rectangle, area 10
+not a rectangle, area 0
+
+dynamic_cast takes longer the further the class of the object is from the class it is cast to, while fast_cast
+always takes the same time, since it only reads type_id and compares it.
+
+Notice that the numbers first and last have to be kept consistent by hand when classes are added; the
+static_assert declarations after the classes check that each class stays inside the range of its base, so
+that a mistake stops the compilation. The constructors that take the number are protected, so that only the
+derived classes can pass their own: new Rectangle (3) would give a Rectangle the number of Triangle, and
+fast_cast<Triangle> would then accept it, so it does not compile. Also notice that fast_cast cannot be used
+to cast between classes of different hierarchies, such as from Polygon* to Derived*: the static_cast inside
+it does not compile, since the classes are not related.
+
+fast_cast gives the same answers as dynamic_cast only for the classes that are numbered. A class derived from
+Square, for example, would have to be given a number, and the ranges of its bases extended, before objects of
+that class can be cast.*/
@@ -0,0 +1,241 @@
+/*Dispatching on the type of an object
+typeid gives a type_info object for each type, and comparing two of them tells whether two types are the same.
+A program that receives messages of many types, all derived from a base class, can use it to call the right
+handler for each message:
+
+if (typeid(*m) == typeid(login)) handle_login (...);
+else if (typeid(*m) == typeid(logout)) handle_logout (...);
+...
+
+With many types, this chain compares the type of each message with every type until it finds it (and with some
+compilers, each comparison compares the names of the types, character by character). Putting the handlers in an
+unordered_map indexed by type_index (a wrapper of type_info, from the header <typeindex>, that can be hashed)
+avoids the chain, but each message still needs a hash and a search in the table.
+
+A faster way is to give each type a small integer: 0 to the first type that asks for one, 1 to the second one,
+and so on. Then the handlers can be kept in a plain vector, and the number of the type of a message is the index
+of its handler. The function dense_type_index assigns these numbers, keeping those already given in a map, which
+is slow, but the function template index_of<T> calls it only once for each type, and keeps the number in a
+static local variable: after the first call, it only reads it.
+
+Messages derive from message_of<T>, with T their own class, which defines the virtual member function
+dense_index to return index_of<T>(). Dispatching a message is then a virtual call to get its number, and a
+read of the vector.
+
+The number is the one of the class given to message_of, not of the real class of the object: a class derived
+from login would inherit the dense_index of login, and be dispatched as a login, while typeid(*m) tells them
+apart. So a message class derived from another one must also go through message_of, which takes the base
+class as a second argument: class admin_login : public message_of<admin_login, login>.*/
+
+// dispatch by type index
+#include <iostream>
+#include <typeinfo>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <chrono>
+using namespace std;
+
+int dense_type_index (const type_info& type)
+{
+  static mutex lock;
+  static unordered_map<type_index,int> numbers;
+  lock_guard<mutex> guard (lock);
+  unordered_map<type_index,int>::iterator it = numbers.find (type);
+  if (it != numbers.end()) return it->second;
+  int number = int (numbers.size());
+  numbers[type] = number;
+  return number;
+}
+
+template <class T>
+int index_of ()
+{
+  static const int number = dense_type_index (typeid(T));
+  return number;
+}
+
+class message {
+  public:
+    virtual ~message () {}
+    virtual int dense_index () const = 0;
+};
+
+// T is the class of the message, and Base the class it derives from
+template <class T, class Base = message>
+class message_of : public Base {
+  public:
+    int dense_index () const {return index_of<T>();}
+};
+
+class dispatcher {
+    typedef void (*handler) (const message&);
+    vector<handler> handlers;
+  public:
+    void on (int index, handler h)
+    {
+      if (index >= int (handlers.size())) handlers.resize (index + 1, nullptr);
+      handlers[index] = h;
+    }
+    // registers a handler that takes the derived type: on<login, handle_login>()
+    template <class T, void (*h) (const T&)>
+    void on ()
+    {
+      on (index_of<T>(), [] (const message& m) {h (static_cast<const T&> (m));});
+    }
+    bool dispatch (const message& m) const
+    {
+      size_t index = m.dense_index();
+      if (index >= handlers.size() || handlers[index] == nullptr) return false;
+      handlers[index] (m);
+      return true;
+    }
+};
+
+class login : public message_of<login> {};
+class logout : public message_of<logout> {};
+class admin_login : public message_of<admin_login, login> {};
+
+void handle_login (const login&) {cout << "login\n";}
+void handle_logout (const logout&) {cout << "logout\n";}
+
+// many message types for the benchmark, generated by a template
+long total = 0;
+
+template <int N>
+class numbered : public message_of<numbered<N> > {
+  public:
+    int value;
+    numbered () : value (N) {}
+};
+
+template <int N>
+void handle_numbered (const numbered<N>& m) {total += m.value;}
+
+struct tables {
+  int count;                                                   // types to register
+  vector<message* (*) ()> factories;
+  vector<pair<const type_info*, void (*) (const message&)> > chain;
+  unordered_map<type_index, void (*) (const message&)> by_hash;
+  dispatcher by_index;
+};
+
+// registers numbered<N> for N in [low, high), splitting the range in halves to keep the recursion shallow
+template <int low, int high>
+struct register_types {
+  static void in (tables& t)
+  {
+    register_types<low, (low+high)/2>::in (t);
+    register_types<(low+high)/2, high>::in (t);
+  }
+};
+
+template <int N>
+struct register_types<N, N+1> {
+  static void in (tables& t)
+  {
+    if (N >= t.count) return;
+    void (*h) (const message&) = [] (const message& m) {handle_numbered (static_cast<const numbered<N>&> (m));};
+    t.factories.push_back ([] () -> message* {return new numbered<N>;});
+    t.chain.push_back (make_pair (&typeid(numbered<N>), h));
+    t.by_hash[type_index (typeid(numbered<N>))] = h;
+    t.by_index.on<numbered<N>, handle_numbered<N> >();
+  }
+};
+
+void benchmark (int count)
+{
+  tables t;
+  t.count = count;
+  register_types<0, 1000>::in (t);
+
+  const int n = 4096, rounds = 20000 / count;          // the chain gets slow with many types
+  vector<message*> messages (n);
+  for (int i=0; i<n; i++)
+    messages[i] = t.factories[((i * 2654435761u) >> 8) % count] ();
+
+  total = 0;
+  auto start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++) {
+      const type_info& type = typeid(*messages[i]);
+      for (size_t k=0; k<t.chain.size(); k++)
+        if (*t.chain[k].first == type) {
+          t.chain[k].second (*messages[i]);
+          break;
+        }
+    }
+  chrono::duration<double,nano> chain_time = chrono::steady_clock::now() - start;
+  long check = total;
+
+  total = 0;
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      t.by_hash[type_index (typeid(*messages[i]))] (*messages[i]);
+  chrono::duration<double,nano> hash_time = chrono::steady_clock::now() - start;
+  if (total != check) cout << "different results\n";
+
+  total = 0;
+  start = chrono::steady_clock::now();
+  for (int r=0; r<rounds; r++)
+    for (int i=0; i<n; i++)
+      t.by_index.dispatch (*messages[i]);
+  chrono::duration<double,nano> index_time = chrono::steady_clock::now() - start;
+  if (total != check) cout << "different results\n";
+
+  double dispatched = double (n) * rounds;
+  cout << count << " types: typeid chain " << chain_time.count() / dispatched << " ns, unordered_map "
+       << hash_time.count() / dispatched << " ns, dense index " << index_time.count() / dispatched << " ns\n";
+  for (int i=0; i<n; i++)
+    delete messages[i];
+}
+
+int main () {
+  int * a,b;
+  cout << "a is: " << typeid(a).name() << ", index " << index_of<int*>() << '\n';
+  cout << "b is: " << typeid(b).name() << ", index " << index_of<int>() << '\n';
+  cout << "int* again: index " << dense_type_index (typeid(a)) << '\n';
+
+  dispatcher d;
+  d.on<login, handle_login>();
+  d.on<logout, handle_logout>();
+  login in;
+  logout out;
+  admin_login admin;
+  message* received[] = {&in, &out, &in, &admin};
+  for (int i=0; i<4; i++)
+    if (!d.dispatch (*received[i])) cout << "no handler for " << typeid(*received[i]).name() << '\n';
+
+  benchmark (10);
+  benchmark (100);
+  benchmark (1000);
+  return 0;
+}
+/*Output (the timings depend on the machine, and so do the names of the types):
+a is: Pi, index 0
+b is: i, index 1
+int* again: index 0
+login
+logout
+login
+no handler for 11admin_login
+
+The time of the typeid chain grows with the number of types, since on average each message is compared with half
+of them. The other two grow much less: with more types, the messages call more different handlers and virtual
+functions, whose code and data no longer fit in the caches of the processor. But the dense index is always the
+fastest, since it only makes a virtual call and reads a vector, without hashing.
+
+admin_login derives from login, but through message_of it has its own number, for which no handler was
+registered, so it is not handled as a login, as with typeid. Had it derived from login directly, the handler
+of login would have been called.
+
+Notice that the numbers are given in the order in which the types ask for them, so they can be different from one
+run of the program to another, and from one program to another: they can be used inside the program, but should
+not be saved to a file or sent to another process.
+
+Also notice how register_types covers the 1000 types: instead of registering N and then calling itself for N+1,
+which would nest 1000 instantiations of the template (more than compilers allow by default), it splits the range
+in two halves, so the instantiations are only nested about 10 levels deep. Even so, the compiler has to generate
+a class, a handler and several functions for each of the 1000 types, so this program takes a while to compile.*/